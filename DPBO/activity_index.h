@@ -0,0 +1,70 @@
+#ifndef ACTIVITY_INDEX_H
+#define ACTIVITY_INDEX_H
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+class BankCustomer;
+
+// Orders a bank's customers by lastActivityTime.
+// BankCustomer reports every activity change, so "inactive since" queries are a range
+// scan from the oldest entry that stops at the cutoff. Each customer keeps the iterator of
+// its own entry, so moving or removing it never scans the customers that share its time.
+class ActivityIndex {
+   public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Entries = std::multimap<TimePoint, const BankCustomer*>;
+
+   private:
+    Entries entries;
+
+   public:
+    Entries::iterator insert(const BankCustomer* customer, TimePoint time) {
+        return entries.emplace(time, customer);
+    }
+
+    void remove(Entries::iterator entry) { entries.erase(entry); }
+
+    // Re-keys an entry in place (no allocation); returns its new position
+    Entries::iterator update(Entries::iterator entry, TimePoint current) {
+        if (entry->first == current) return entry;
+        auto node = entries.extract(entry);
+        node.key() = current;
+        return entries.insert(std::move(node));
+    }
+
+    // [begin(), endOfInactive(cutoff)) holds the entries active at or before cutoff
+    Entries::const_iterator begin() const { return entries.begin(); }
+    Entries::const_iterator endOfInactive(TimePoint cutoff) const {
+        return entries.upper_bound(cutoff);
+    }
+
+    // Customers whose last activity is at or before cutoff, oldest first
+    std::vector<const BankCustomer*> inactiveSince(TimePoint cutoff) const {
+        std::vector<const BankCustomer*> customers;
+        for (auto it = entries.begin(), end = endOfInactive(cutoff); it != end; ++it) {
+            customers.push_back(it->second);
+        }
+        return customers;
+    }
+
+    size_t countInactiveSince(TimePoint cutoff) const {
+        size_t count = 0;
+        for (auto it = entries.begin(), end = endOfInactive(cutoff); it != end; ++it) count++;
+        return count;
+    }
+
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+};
+
+// Projection for query views over ActivityIndex entries
+struct ActivityEntryProjection {
+    const BankCustomer& operator()(const ActivityIndex::Entries::value_type& entry) const {
+        return *entry.second;
+    }
+};
+
+#endif
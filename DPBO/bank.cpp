@@ -2,13 +2,116 @@
 
 #include <algorithm>
 #include <chrono>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Records per partition below which the report engine stays on one thread
+const size_t MIN_PARTITION_SIZE = 1 << 16;
+
+size_t partitionCount(size_t size) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, size / MIN_PARTITION_SIZE));
+}
+
+// Runs work(partition, totals) for every partition, each on its own thread, then merges the
+// partial totals in partition order
+template <typename Totals, typename Work>
+Totals runPartitions(size_t partitions, Work work) {
+    std::vector<Totals> partials(partitions);
+    std::vector<std::thread> workers;
+    for (size_t p = 1; p < partitions; p++) {
+        workers.emplace_back([&work, &partials, p] { work(p, partials[p]); });
+    }
+    work(0, partials[0]);
+    for (auto& worker : workers) worker.join();
+
+    Totals totals;
+    for (auto& partial : partials) totals.merge(partial);
+    return totals;
+}
+
+// Mergeable aggregate of one pass over the ledger
+struct LedgerTotals {
+    size_t recentCount = 0;
+    double recentValue = 0.0;
+    std::unordered_map<std::string, int> todayCounts;
+
+    void merge(LedgerTotals& other) {
+        recentCount += other.recentCount;
+        recentValue += other.recentValue;
+        if (todayCounts.empty()) {
+            todayCounts.swap(other.todayCounts);
+            return;
+        }
+        for (const auto& pair : other.todayCounts) todayCounts[pair.first] += pair.second;
+    }
+};
+
+// Covers the hot part of the ledger only, so recentDays must stay within Bank::HOT_DAYS
+LedgerTotals aggregateLedger(const std::deque<BankTransaction>& transactions,
+                             std::chrono::system_clock::time_point now, int recentDays) {
+    size_t partitions = partitionCount(transactions.size());
+    size_t chunk = (transactions.size() + partitions - 1) / partitions;
+
+    return runPartitions<LedgerTotals>(partitions, [&](size_t p, LedgerTotals& totals) {
+        size_t end = std::min(transactions.size(), (p + 1) * chunk);
+        for (size_t i = p * chunk; i < end; i++) {
+            const BankTransaction& t = transactions[i];
+            auto diff =
+                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
+            if (diff <= (recentDays * 24)) {
+                totals.recentCount++;
+                totals.recentValue += t.getAmount();
+            }
+            if (diff <= 24) {
+                totals.todayCounts[t.getFromAccount()]++;
+                if (t.getToAccount() != t.getFromAccount()) totals.todayCounts[t.getToAccount()]++;
+            }
+        }
+    });
+}
+
+// The n customers with the most transactions today, padded with idle customers in the order
+// they were added
+std::vector<std::pair<const BankCustomer*, int>> selectMostActive(
+    const CustomerTable& customers, const std::unordered_map<std::string, int>& todayCounts,
+    size_t n) {
+    std::vector<std::pair<const BankCustomer*, int>> active;
+    for (const auto& pair : todayCounts) {
+        if (const BankCustomer* customer = customers.find(pair.first)) {
+            active.emplace_back(customer, pair.second);
+        }
+    }
+
+    auto busier = [](const auto& a, const auto& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return a.first->getAccountNumber() < b.first->getAccountNumber();
+    };
+    size_t top = std::min(n, active.size());
+    std::partial_sort(active.begin(), active.begin() + top, active.end(), busier);
+    active.resize(top);
+
+    for (auto it = customers.begin(); it != customers.end() && active.size() < n; ++it) {
+        if (todayCounts.find(it->getAccountNumber()) == todayCounts.end()) {
+            active.emplace_back(&*it, 0);
+        }
+    }
+    return active;
+}
+
+}  // namespace
 
 void Bank::loadData() {
-    std::ifstream file("bank_data.bin", std::ios::binary);
+    if (filePrefix.empty()) return;
+    std::ifstream file(filePrefix + "_data.bin", std::ios::binary);
     if (file.is_open()) {
         // Load bank info
         int nameLen, addrLen, phoneLen;
@@ -21,22 +124,81 @@ void Bank::loadData() {
         name = nameBuf;
         delete[] nameBuf;
 
-        // Load customers
+        // Load customers; their histories stay in the history store
         size_t customerCount;
         file.read(reinterpret_cast<char*>(&customerCount), sizeof(customerCount));
+        std::vector<BankCustomer*> loaded;
         for (size_t i = 0; i < customerCount; i++) {
             BankCustomer customer;
             customer.deserialize(file);
-            customers[customer.getAccountNumber()] = customer;
+            loaded.push_back(&storeCustomer(customer));
+            ids.observe(SequenceKind::CUSTOMER, customer.getId());
         }
 
-        // Load transactions
+        // Load the in-memory part of the ledger
         size_t transactionCount;
         file.read(reinterpret_cast<char*>(&transactionCount), sizeof(transactionCount));
-        for (size_t i = 0; i < transactionCount; i++) {
-            BankTransaction transaction;
+        std::vector<BankTransaction> hot(transactionCount);
+        for (auto& transaction : hot) {
             transaction.deserialize(file);
-            transactions.push_back(transaction);
+            ids.observe(SequenceKind::TRANSACTION, transaction.getId());
+        }
+
+        // Load id high-water marks, then the directory of sealed ledger segments (both
+        // absent in older files, whose ledger is then all in memory)
+        KeyedQuantiles<int64_t> savedDailyAmounts(QUANTILE_DAYS);
+        KeyedQuantiles<int> savedTierAmounts;
+        bool amountsSaved = false;
+        size_t locationCount = 0;
+        if (ids.deserialize(file) && transactions.deserializeDirectory(file) &&
+            file.read(reinterpret_cast<char*>(&locationCount), sizeof(locationCount))) {
+            // Where each customer's history is in the history store, in customer order
+            // (absent in older files, whose histories are inline and move to the store
+            // on the next save)
+            bool complete = true;
+            uint64_t liveRecords = 0;
+            for (size_t i = 0; i < locationCount; i++) {
+                HistoryLocation location;
+                if (!file.read(reinterpret_cast<char*>(&location), sizeof(location))) {
+                    complete = false;
+                    break;
+                }
+                if (i < loaded.size()) loaded[i]->restoreHistoryLocation(location);
+                liveRecords += location.count;
+            }
+
+            // The amount sketches, which also cover sealed transactions
+            amountsSaved = complete && savedDailyAmounts.deserialize(file) &&
+                           savedTierAmounts.deserialize(file);
+
+            // The history file size in records; without it only the live runs are known
+            uint64_t historyRecords = 0;
+            if (!amountsSaved ||
+                !file.read(reinterpret_cast<char*>(&historyRecords), sizeof(historyRecords))) {
+                historyRecords = liveRecords;
+            } else {
+                // Velocity tier limits and account tiers (absent in older files, whose
+                // accounts are all in tier 0 without limits)
+                velocity.deserialize(file);
+            }
+            histories->setFileRecords(historyRecords);
+        }
+        for (const auto& transaction : hot) transactions.push_back(transaction);
+
+        // Rebuild the velocity windows from the last 24 hours of the ledger, and the amount
+        // sketches from the in-memory ledger when the file has none
+        auto now = clock->now();
+        for (const auto& transaction : transactions.getHot()) {
+            size_t sender = customers.indexOf(transaction.getFromAccount());
+            if (sender != CustomerTable::NPOS) {
+                velocity.record(static_cast<uint32_t>(sender), transaction.getAmount(),
+                                transaction.getTimestamp(), now);
+            }
+            if (!amountsSaved) recordAmount(transaction);
+        }
+        if (amountsSaved) {
+            dailyAmounts = std::move(savedDailyAmounts);
+            tierAmounts = std::move(savedTierAmounts);
         }
 
         file.close();
@@ -44,7 +206,8 @@ void Bank::loadData() {
 }
 
 void Bank::saveData() const {
-    std::ofstream file("bank_data.bin", std::ios::binary);
+    if (filePrefix.empty()) return;
+    std::ofstream file(filePrefix + "_data.bin", std::ios::binary);
     if (file.is_open()) {
         // Save bank info
         int nameLen = name.length();
@@ -52,112 +215,257 @@ void Bank::saveData() const {
         file.write(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
         file.write(name.c_str(), nameLen);
 
-        // Save customers
+        // Save customers; changed histories are appended to the history store first, so
+        // the records only carry the customer fields
         size_t customerCount = customers.size();
         file.write(reinterpret_cast<const char*>(&customerCount), sizeof(customerCount));
-        for (const auto& pair : customers) {
-            pair.second.serialize(file);
+        std::vector<HistoryLocation> locations;
+        locations.reserve(customerCount);
+        uint64_t liveRecords = 0;
+        for (const auto& customer : customers) {
+            locations.push_back(customer.saveHistory());
+            liveRecords += locations.back().count;
+            customer.serialize(file);
+        }
+
+        // Rewrite the history file once superseded runs make up most of it
+        if (histories->needsCompaction(liveRecords) && histories->compact(locations)) {
+            size_t i = 0;
+            for (const auto& customer : customers) customer.relocateHistory(locations[i++]);
         }
 
-        // Save transactions
-        size_t transactionCount = transactions.size();
+        // Save the in-memory part of the ledger
+        size_t transactionCount = transactions.getHot().size();
         file.write(reinterpret_cast<const char*>(&transactionCount), sizeof(transactionCount));
-        for (const auto& transaction : transactions) {
+        for (const auto& transaction : transactions.getHot()) {
             transaction.serialize(file);
         }
 
+        // Save id high-water marks and the directory of sealed segments
+        ids.serialize(file);
+        transactions.serializeDirectory(file);
+
+        // Save the history locations, in customer order
+        file.write(reinterpret_cast<const char*>(&customerCount), sizeof(customerCount));
+        file.write(reinterpret_cast<const char*>(locations.data()),
+                   locations.size() * sizeof(HistoryLocation));
+
+        // Save the amount sketches, then the size of the history file in records
+        dailyAmounts.serialize(file);
+        tierAmounts.serialize(file);
+        uint64_t historyRecords = histories->getFileRecords();
+        file.write(reinterpret_cast<const char*>(&historyRecords), sizeof(historyRecords));
+
+        // Save the velocity tier limits and account tiers, by customer position
+        velocity.serialize(file);
+
         file.close();
     }
 }
 
 // Constructor implementation
-Bank::Bank() : id(0), name(""), address(""), phoneNumber("") { loadData(); }
+Bank::Bank()
+    : id(0),
+      name(""),
+      address(""),
+      phoneNumber(""),
+      filePrefix("bank"),
+      histories(std::make_shared<HistoryStore>("bank_history.bin")),
+      transactions("bank_ledger"),
+      dailyAmounts(QUANTILE_DAYS),
+      clock(&SystemClock::instance()) {
+    loadData();
+    sealColdTransactions();
+}
+
+Bank::Bank(std::string filePrefix)
+    : id(0),
+      name(""),
+      address(""),
+      phoneNumber(""),
+      filePrefix(std::move(filePrefix)),
+      histories(std::make_shared<HistoryStore>(
+          this->filePrefix.empty() ? "" : this->filePrefix + "_history.bin")),
+      transactions(this->filePrefix.empty() ? "" : this->filePrefix + "_ledger"),
+      dailyAmounts(QUANTILE_DAYS),
+      clock(&SystemClock::instance()) {
+    loadData();
+    sealColdTransactions();
+}
 
 Bank::Bank(int id, std::string name, std::string address, std::string phoneNumber)
-    : id(id), name(name), address(address), phoneNumber(phoneNumber) {
+    : id(id),
+      name(name),
+      address(address),
+      phoneNumber(phoneNumber),
+      filePrefix("bank"),
+      histories(std::make_shared<HistoryStore>("bank_history.bin")),
+      transactions("bank_ledger"),
+      dailyAmounts(QUANTILE_DAYS),
+      clock(&SystemClock::instance()) {
     loadData();
+    sealColdTransactions();
+}
+
+Bank::Bank(const Bank& other)
+    : id(other.id),
+      name(other.name),
+      address(other.address),
+      phoneNumber(other.phoneNumber),
+      filePrefix(other.filePrefix),
+      customers(other.customers),
+      histories(other.histories),
+      transactions(other.transactions),
+      velocity(other.velocity),
+      dailyAmounts(other.dailyAmounts),
+      tierAmounts(other.tierAmounts),
+      ids(other.ids),
+      clock(other.clock) {
+    for (auto& customer : customers) {
+        customer.attachActivityIndex(&activityIndex);
+    }
+}
+
+Bank& Bank::operator=(const Bank& other) {
+    if (this != &other) {
+        id = other.id;
+        name = other.name;
+        address = other.address;
+        phoneNumber = other.phoneNumber;
+        filePrefix = other.filePrefix;
+        customers = other.customers;
+        histories = other.histories;
+        transactions = other.transactions;
+        velocity = other.velocity;
+        dailyAmounts = other.dailyAmounts;
+        tierAmounts = other.tierAmounts;
+        ids = other.ids;
+        clock = other.clock;
+        for (auto& customer : customers) {
+            customer.attachActivityIndex(&activityIndex);
+        }
+    }
+    return *this;
 }
 
-Bank::~Bank() { saveData(); }
+Bank::~Bank() {
+    sealColdTransactions();
+    saveData();
+}
+
+// Adds the customer, or overwrites the one with the same account number
+BankCustomer& Bank::storeCustomer(const BankCustomer& customer) {
+    auto stored = customers.insert(customer);
+    if (!stored.second) *stored.first = customer;
+    stored.first->attachActivityIndex(&activityIndex);
+    stored.first->attachHistoryStore(histories);
+    return *stored.first;
+}
 
 // Customer management implementations
 bool Bank::addCustomer(const BankCustomer& customer) {
-    std::string accountNumber = customer.getAccountNumber();
-    if (customers.find(accountNumber) == customers.end()) {
-        customers[accountNumber] = customer;
-        return true;
-    }
-    return false;
+    auto stored = customers.insert(customer);
+    if (!stored.second) return false;
+    stored.first->attachActivityIndex(&activityIndex);
+    stored.first->attachHistoryStore(histories);
+    ids.observe(SequenceKind::CUSTOMER, customer.getId());
+    return true;
 }
 
-BankCustomer* Bank::findCustomer(const std::string& accountNumber) {
-    auto it = customers.find(accountNumber);
-    return it != customers.end() ? &(it->second) : nullptr;
+void Bank::recordAmount(const BankTransaction& transaction) {
+    dailyAmounts.add(dayOf(transaction.getTimestamp()), transaction.getAmount());
+    size_t sender = customers.indexOf(transaction.getFromAccount());
+    int tier = sender != CustomerTable::NPOS
+                   ? velocity.getAccountTier(static_cast<uint32_t>(sender))
+                   : 0;
+    tierAmounts.add(tier, transaction.getAmount());
+}
+
+bool Bank::setAccountTier(std::string_view accountNumber, int tier) {
+    size_t index = customers.indexOf(accountNumber);
+    if (index == CustomerTable::NPOS) return false;
+    velocity.setAccountTier(static_cast<uint32_t>(index), tier);
+    return true;
+}
+
+BankCustomer* Bank::findCustomer(std::string_view accountNumber) {
+    return customers.find(accountNumber);
 }
 
 // Transaction methods implementation
 bool Bank::processTransaction(BankTransaction& transaction) {
-    auto* sender = findCustomer(transaction.getFromAccount());
+    // Only positive amounts move money; a negative one would run the transfer backwards
+    if (!(transaction.getAmount() > 0.0)) return false;
+    size_t senderIndex = customers.indexOf(transaction.getFromAccount());
+    auto* sender = senderIndex != CustomerTable::NPOS ? &customers.at(senderIndex) : nullptr;
     auto* receiver = findCustomer(transaction.getToAccount());
-
-    if (sender && receiver && sender->getBalance() >= transaction.getAmount()) {
-        sender->withdraw(transaction.getAmount());
-        receiver->deposit(transaction.getAmount());
+    auto now = clock->now();
+
+    // The velocity check runs last and counts the transfer, which cannot fail after it
+    if (sender && receiver && sender->getBalance() >= transaction.getAmount() &&
+        velocity.tryConsume(static_cast<uint32_t>(senderIndex), transaction.getAmount(), now)) {
+        sender->withdraw(transaction.getAmount(), now);
+        receiver->deposit(transaction.getAmount(), now);
+        sender->addTransaction(transaction);
+        receiver->addTransaction(transaction);
         transactions.push_back(transaction);
+        ids.observe(SequenceKind::TRANSACTION, transaction.getId());
+        recordAmount(transaction);
+
+        // Seal in day-sized batches rather than on every transfer
+        if (transactions.getHot().front().getTimestamp() <
+            now - std::chrono::hours((HOT_DAYS + 1) * 24)) {
+            sealColdTransactions();
+        }
         return true;
     }
     return false;
 }
 
 std::vector<BankTransaction> Bank::getRecentTransactions(int days) const {
-    std::vector<BankTransaction> recent;
-    auto now = std::chrono::system_clock::now();
+    auto now = clock->now();
+    if (days <= HOT_DAYS) return recentTransactionsView(days).toVector();
 
-    std::copy_if(
-        transactions.begin(), transactions.end(), std::back_inserter(recent),
-        [now, days](const BankTransaction& t) {
-            auto diff =
-                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
-            return diff <= (days * 24);
-        });
+    std::vector<BankTransaction> recent;
+    transactions.forEachSince(now - std::chrono::hours((days + 1) * 24),
+                              [&recent, now, days](const BankTransaction& t) {
+                                  auto diff = std::chrono::duration_cast<std::chrono::hours>(
+                                                  now - t.getTimestamp())
+                                                  .count();
+                                  if (diff <= (days * 24)) recent.push_back(t);
+                              });
     return recent;
 }
 
-std::vector<BankCustomer> Bank::getDormantAccounts() const {
-    std::vector<BankCustomer> dormant;
-    auto now = std::chrono::system_clock::now();
+void Bank::sealColdTransactions() {
+    transactions.sealBefore(clock->now() - std::chrono::hours(HOT_DAYS * 24));
+}
 
-    for (const auto& pair : customers) {
-        auto lastActivity = pair.second.getLastActivityTime();
-        auto diff = std::chrono::duration_cast<std::chrono::hours>(now - lastActivity).count();
-        if (diff >= (30 * 24)) {
-            dormant.push_back(pair.second);
-        }
-    }
-    return dormant;
+std::vector<BankCustomer> Bank::getDormantAccounts(int days) const {
+    return dormantAccountsView(days).toVector();
+}
+
+std::vector<const BankCustomer*> Bank::getDormantAccountHandles(int days) const {
+    auto cutoff = clock->now() - std::chrono::hours(days * 24);
+    return activityIndex.inactiveSince(cutoff);
 }
 
 std::vector<BankCustomer> Bank::getMostActiveUsers(int n) const {
     std::vector<BankCustomer> active;
-    for (const auto& pair : customers) {
-        active.push_back(pair.second);
-    }
-
-    // Sort by transaction count in the last 24 hours
-    std::sort(active.begin(), active.end(), [this](const BankCustomer& a, const BankCustomer& b) {
-        return countTodayTransactions(a) > countTodayTransactions(b);
-    });
+    if (n <= 0) return active;
 
-    if (active.size() > n) {
-        active.resize(n);
+    // Count each customer's transactions of the last 24 hours in one pass over the ledger
+    auto ledger = aggregateLedger(transactions.getHot(), clock->now(), 0);
+    for (const auto& pair : selectMostActive(customers, ledger.todayCounts, n)) {
+        active.push_back(*pair.first);
     }
     return active;
 }
 
-int Bank::countTodayTransactions(const BankCustomer& customer) const {
-    auto now = std::chrono::system_clock::now();
+int Bank::countTodayTransactions(const BankCustomer& customer,
+                                 std::chrono::system_clock::time_point now) const {
     return std::count_if(
-        transactions.begin(), transactions.end(), [&customer, now](const BankTransaction& t) {
+        transactions.hotBegin(), transactions.hotEnd(), [&customer, now](const BankTransaction& t) {
             auto diff =
                 std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
             return diff <= 24 && (t.getFromAccount() == customer.getAccountNumber() ||
@@ -165,35 +473,72 @@ int Bank::countTodayTransactions(const BankCustomer& customer) const {
         });
 }
 
+void Bank::addMemoryUsage(MemoryReport& report) const {
+    MemoryUsage customerUsage;
+    MemoryUsage historyUsage;
+    customerUsage.objects = customers.size();
+    customerUsage.bytes = customers.size() * sizeof(BankCustomer) + customers.slotBytes();
+    for (const auto& customer : customers) {
+        customer.addHeapUsage(customerUsage);
+        customer.addHistoryUsage(historyUsage);
+    }
+    histories->addMemoryUsage(historyUsage);
+
+    MemoryUsage ledgerUsage;
+    transactions.addMemoryUsage(ledgerUsage);
+    for (const auto& transaction : transactions.getHot()) transaction.addHeapUsage(ledgerUsage);
+
+    report.add("bank.customers", customerUsage);
+    report.add("bank.customer_transactions", historyUsage);
+    report.add("bank.transactions", ledgerUsage);
+
+    MemoryUsage sketchUsage;
+    dailyAmounts.addMemoryUsage(sketchUsage);
+    tierAmounts.addMemoryUsage(sketchUsage);
+    report.add("bank.amount_quantiles", sketchUsage);
+
+    MemoryUsage velocityUsage;
+    velocity.addMemoryUsage(velocityUsage);
+    report.add("bank.velocity", velocityUsage);
+}
+
 std::string Bank::generateReport() const {
     std::ostringstream report;
-    auto now = std::chrono::system_clock::now();
+    auto now = clock->now();
 
     report << "Bank Report - " << name << "\n";
     report << "================================\n\n";
 
+    // Ledger metrics come from one partitioned pass; dormant accounts from the activity index
+    auto dormantCutoff = now - std::chrono::hours(30 * 24);
+    auto ledgerTotals = aggregateLedger(transactions.getHot(), now, 7);
+
     // Customer Statistics
     report << "Customer Statistics:\n";
     report << "Total Customers: " << customers.size() << "\n";
-    report << "Dormant Accounts: " << getDormantAccounts().size() << "\n\n";
+    report << "Dormant Accounts: " << activityIndex.countInactiveSince(dormantCutoff) << "\n\n";
 
     // Transaction Statistics
-    auto recentTrans = getRecentTransactions(7);
     report << "Transaction Statistics (Last 7 Days):\n";
-    report << "Total Transactions: " << recentTrans.size() << "\n";
-
-    double totalValue = 0.0;
-    for (const auto& trans : recentTrans) {
-        totalValue += trans.getAmount();
-    }
-    report << "Total Transaction Value: $" << std::fixed << std::setprecision(2) << totalValue
-           << "\n\n";
+    report << "Total Transactions: " << ledgerTotals.recentCount << "\n";
+    report << "Total Transaction Value: $" << std::fixed << std::setprecision(2)
+           << ledgerTotals.recentValue << "\n\n";
 
     // Most Active Users
-    auto activeUsers = getMostActiveUsers(5);
     report << "Top 5 Most Active Users Today:\n";
-    for (const auto& user : activeUsers) {
-        report << user.getName() << " - " << countTodayTransactions(user) << " transactions\n";
+    for (const auto& pair : selectMostActive(customers, ledgerTotals.todayCounts, 5)) {
+        report << pair.first->getName() << " - " << pair.second << " transactions\n";
+    }
+
+    // Amount quantiles from the streaming sketches
+    int64_t today = dayOf(now);
+    const QuantileSketch* todayAmounts = dailyAmounts.find(today);
+    report << "\nTransfer Amounts:\n";
+    report << "Today: " << (todayAmounts ? todayAmounts->summary() : QuantileSketch().summary())
+           << "\n";
+    report << "Last 7 Days: " << dailyAmounts.mergedRange(today - 6, today).summary() << "\n";
+    for (const auto& pair : tierAmounts) {
+        report << "Tier " << pair.first << ": " << pair.second.summary() << "\n";
     }
 
     return report.str();
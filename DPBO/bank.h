@@ -2,12 +2,22 @@
 #define BANK_H
 
 #include <chrono>
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "activity_index.h"
 #include "bank_customer.h"
 #include "bank_transaction.h"
+#include "clock.h"
+#include "customer_table.h"
+#include "id_sequence.h"
+#include "memory_usage.h"
+#include "quantile_sketch.h"
+#include "query_view.h"
+#include "tiered_log.h"
+#include "velocity_limiter.h"
 
 class Bank {
    private:
@@ -15,16 +25,35 @@ class Bank {
     std::string name;
     std::string address;
     std::string phoneNumber;
-    std::map<std::string, BankCustomer> customers;
-    std::vector<BankTransaction> transactions;
+    std::string filePrefix;       // names the data, history and ledger files; empty: memory only
+    ActivityIndex activityIndex;  // declared before customers, which unregister on destruction
+    CustomerTable customers;
+    std::shared_ptr<HistoryStore> histories;  // customer histories, loaded on first use
+    TieredLog<BankTransaction> transactions;  // last HOT_DAYS in memory, older ones on disk
+    VelocityLimiter velocity;
+    KeyedQuantiles<int64_t> dailyAmounts;  // transfer amounts per day, last QUANTILE_DAYS
+    KeyedQuantiles<int> tierAmounts;       // transfer amounts per sender tier
+    IdSequence ids;
+    const Clock* clock;
 
     void loadData();
     void saveData() const;
-    int countTodayTransactions(const BankCustomer& customer) const;
+    BankCustomer& storeCustomer(const BankCustomer& customer);
+    void recordAmount(const BankTransaction& transaction);
+    int countTodayTransactions(const BankCustomer& customer,
+                               std::chrono::system_clock::time_point now) const;
 
    public:
+    static constexpr size_t QUANTILE_DAYS = 31;
+    static constexpr int HOT_DAYS = 31;
+
     Bank();
     Bank(int id, std::string name, std::string address, std::string phoneNumber);
+    // A bank persisted under filePrefix ("bank" for the others); an empty prefix keeps it in
+    // memory only, e.g. for benchmarks
+    explicit Bank(std::string filePrefix);
+    Bank(const Bank& other);
+    Bank& operator=(const Bank& other);
     ~Bank();
 
     // Getters
@@ -39,20 +68,79 @@ class Bank {
     void setAddress(std::string address) { this->address = address; }
     void setPhoneNumber(std::string phoneNumber) { this->phoneNumber = phoneNumber; }
 
+    // Time source for all time-window queries; the clock must outlive the bank
+    void setClock(const Clock& clock) { this->clock = &clock; }
+    const Clock& getClock() const { return *clock; }
+
+    // Id allocation
+    int nextCustomerId() { return ids.next(SequenceKind::CUSTOMER); }
+    int nextTransactionId() { return ids.next(SequenceKind::TRANSACTION); }
+    IdSequence& getIdSequence() { return ids; }
+
     // Customer management
     bool addCustomer(const BankCustomer& customer);
-    BankCustomer* findCustomer(const std::string& accountNumber);
+    BankCustomer* findCustomer(std::string_view accountNumber);
+
+    // Transfer limits per tier over a rolling 24 hours, enforced by processTransaction
+    void setVelocityLimits(int tier, const VelocityLimits& limits) {
+        velocity.setTierLimits(tier, limits);
+    }
+    // Returns false for an unknown account
+    bool setAccountTier(std::string_view accountNumber, int tier);
+    VelocityLimiter& getVelocityLimiter() { return velocity; }
+
+    // Customer histories stay on disk until a customer's getTransactions(); at most
+    // this many history records are kept in memory, least recently used released first
+    void setMaxResidentHistoryRecords(size_t records) {
+        histories->setMaxResidentRecords(records);
+    }
+    const HistoryStore& getHistoryStore() const { return *histories; }
+
+    // Streaming quantiles of successful transfer amounts
+    const KeyedQuantiles<int64_t>& getDailyAmountQuantiles() const { return dailyAmounts; }
+    const KeyedQuantiles<int>& getTierAmountQuantiles() const { return tierAmounts; }
 
     // Transaction methods
     bool processTransaction(BankTransaction& transaction);
+    // Reads sealed segments from disk when days reaches past the hot window
     std::vector<BankTransaction> getRecentTransactions(int days) const;
+    // Moves ledger entries older than HOT_DAYS to disk; also runs as the ledger grows
+    void sealColdTransactions();
+
+    // Lazy views over internal storage; records are only copied on toVector()
+    auto customersView() const {
+        return makeQueryView(customers.begin(), customers.end());
+    }
+
+    // The in-memory part of the ledger: at least the last HOT_DAYS
+    auto transactionsView() const {
+        return makeQueryView(transactions.hotBegin(), transactions.hotEnd());
+    }
+
+    auto recentTransactionsView(int days) const {
+        auto now = clock->now();
+        return transactionsView().where([now, days](const BankTransaction& t) {
+            auto diff =
+                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
+            return diff <= (days * 24);
+        });
+    }
+
+    // Customers inactive for at least the given number of days, oldest activity first
+    auto dormantAccountsView(int days = 30) const {
+        auto cutoff = clock->now() - std::chrono::hours(days * 24);
+        return makeQueryView(activityIndex.begin(), activityIndex.endOfInactive(cutoff),
+                             ActivityEntryProjection());
+    }
 
     // Analytics methods
-    std::vector<BankCustomer> getDormantAccounts() const;
+    std::vector<BankCustomer> getDormantAccounts(int days = 30) const;
+    std::vector<const BankCustomer*> getDormantAccountHandles(int days = 30) const;
     std::vector<BankCustomer> getMostActiveUsers(int n) const;
 
     // Utility methods
     std::string generateReport() const;
+    void addMemoryUsage(MemoryReport& report) const;
 };
 
 #endif
@@ -3,10 +3,15 @@
 
 #include <chrono>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "activity_index.h"
 #include "bank_transaction.h"
+#include "customer_history.h"
+#include "memory_usage.h"
+#include "serialization.h"
 
 class BankCustomer {
    private:
@@ -15,107 +20,251 @@ class BankCustomer {
     std::string accountNumber;
     double balance;
     std::chrono::system_clock::time_point lastActivityTime;
-    std::vector<BankTransaction> transactions;
+    ActivityIndex* activityIndex;  // set by the owning Bank, never copied
+    ActivityIndex::Entries::iterator activityEntry;  // valid while activityIndex is set
+
+    // Transaction history. With a history store the history is read on first use and may
+    // be released again by the store's LRU; mutable because loading is logically const.
+    // A dirty history holds records the store does not have yet; it is appended to the
+    // store when the LRU releases it, so changed histories are bounded like the rest.
+    mutable std::vector<BankTransaction> transactions;
+    mutable HistoryLocation historyLocation;
+    mutable bool historyResident;
+    mutable bool historyDirty;
+    std::shared_ptr<HistoryStore> historyStore;  // shared with copies, which load on their own
+
+    void setLastActivityTime(std::chrono::system_clock::time_point time) {
+        lastActivityTime = time;
+        if (activityIndex) activityEntry = activityIndex->update(activityEntry, time);
+    }
+
+    // Saves a dirty history first; one that cannot be saved stays resident
+    void releaseHistory() const {
+        saveHistory();
+        if (historyDirty) return;
+        std::vector<BankTransaction>().swap(transactions);
+        historyResident = false;
+    }
+
+    // Marks the resident history recently used, which may release other customers'
+    // histories but never this one
+    void touchHistory() const {
+        for (const BankCustomer* released : historyStore->touch(this, transactions.size())) {
+            released->releaseHistory();
+        }
+    }
+
+    // Reads the history from the store on first use and marks it recently used
+    void loadHistory() const {
+        if (historyStore) {
+            if (!historyResident) {
+                transactions = historyStore->read(historyLocation);
+                historyResident = true;
+            }
+            touchHistory();
+        }
+    }
+
+    friend struct SerializationAccess;
+
+    // Record layout; the activity time goes through setLastActivityTime on load so the
+    // owning bank's activity index stays in sync
+    static constexpr auto serializationFields() {
+        using Rep = std::chrono::system_clock::rep;
+        return std::make_tuple(
+            serialization::raw(&BankCustomer::id), serialization::string(&BankCustomer::name),
+            serialization::string(&BankCustomer::accountNumber),
+            serialization::raw(&BankCustomer::balance),
+            serialization::property<BankCustomer, Rep>(
+                [](const BankCustomer& customer) {
+                    return customer.lastActivityTime.time_since_epoch().count();
+                },
+                [](BankCustomer& customer, Rep ticks) {
+                    customer.setLastActivityTime(std::chrono::system_clock::time_point(
+                        std::chrono::system_clock::duration(ticks)));
+                }),
+            serialization::list(&BankCustomer::transactions));
+    }
+
+    // Takes over the history state; a history the store already has is not copied but
+    // read again by this customer when needed
+    void copyHistory(const BankCustomer& other) {
+        if (historyStore) historyStore->forget(this);
+        historyStore = other.historyStore;
+        historyLocation = other.historyLocation;
+        historyDirty = other.historyDirty;
+        historyResident = !historyStore || historyDirty || historyLocation.count == 0;
+        if (historyResident) {
+            transactions = other.transactions;
+        } else {
+            std::vector<BankTransaction>().swap(transactions);
+        }
+    }
 
    public:
-    BankCustomer() : id(0), name(""), accountNumber(""), balance(0.0) {
+    BankCustomer()
+        : id(0),
+          name(""),
+          accountNumber(""),
+          balance(0.0),
+          activityIndex(nullptr),
+          historyResident(true),
+          historyDirty(false) {
         lastActivityTime = std::chrono::system_clock::now();
     }
 
-    BankCustomer(int id, std::string name, std::string accountNumber)
-        : id(id), name(name), accountNumber(accountNumber), balance(0.0) {
-        lastActivityTime = std::chrono::system_clock::now();
+    // created is the initial activity time; pass the owning bank's clock time
+    BankCustomer(int id, std::string name, std::string accountNumber,
+                 std::chrono::system_clock::time_point created = std::chrono::system_clock::now())
+        : id(id),
+          name(name),
+          accountNumber(accountNumber),
+          balance(0.0),
+          lastActivityTime(created),
+          activityIndex(nullptr),
+          historyResident(true),
+          historyDirty(false) {}
+
+    BankCustomer(const BankCustomer& other)
+        : id(other.id),
+          name(other.name),
+          accountNumber(other.accountNumber),
+          balance(other.balance),
+          lastActivityTime(other.lastActivityTime),
+          activityIndex(nullptr) {
+        copyHistory(other);
+    }
+
+    BankCustomer& operator=(const BankCustomer& other) {
+        if (this != &other) {
+            id = other.id;
+            name = other.name;
+            accountNumber = other.accountNumber;
+            balance = other.balance;
+            copyHistory(other);
+            setLastActivityTime(other.lastActivityTime);
+        }
+        return *this;
+    }
+
+    ~BankCustomer() {
+        if (activityIndex) activityIndex->remove(activityEntry);
+        if (historyStore) historyStore->forget(this);
     }
 
+    // Registers this customer in a bank's activity index
+    void attachActivityIndex(ActivityIndex* index) {
+        if (activityIndex) activityIndex->remove(activityEntry);
+        activityIndex = index;
+        if (activityIndex) activityEntry = activityIndex->insert(this, lastActivityTime);
+    }
+
+    // Moves the history into a bank's history store. A history that is not in the store
+    // yet (new, changed or loaded from an inline record) is appended when it is saved or
+    // released by the LRU.
+    void attachHistoryStore(std::shared_ptr<HistoryStore> store) {
+        if (store == historyStore) return;
+        loadHistory();
+        if (historyStore) historyStore->forget(this);
+        historyStore = std::move(store);
+        historyLocation = HistoryLocation();
+        historyDirty = !transactions.empty();
+        if (historyStore && historyDirty) touchHistory();
+    }
+
+    // Points a clean history at its saved run, which is read on first use
+    void restoreHistoryLocation(const HistoryLocation& location) {
+        if (!historyStore || historyDirty) return;
+        historyStore->forget(this);
+        releaseHistory();
+        historyLocation = location;
+        historyResident = location.count == 0;
+    }
+
+    // Appends a dirty history to the store; returns where the saved history is
+    HistoryLocation saveHistory() const {
+        if (historyStore && historyDirty) {
+            historyLocation = historyStore->append(transactions);
+            historyDirty = historyLocation.count != transactions.size();
+        }
+        return historyLocation;
+    }
+
+    // Follows a compaction of the history store; the saved records themselves are unchanged
+    void relocateHistory(const HistoryLocation& location) const {
+        if (historyStore && !historyDirty) historyLocation = location;
+    }
+
+    bool isHistoryResident() const { return historyResident; }
+
     // Getters
     int getId() const { return id; }
     std::string getName() const { return name; }
-    std::string getAccountNumber() const { return accountNumber; }
+    const std::string& getAccountNumber() const { return accountNumber; }
     double getBalance() const { return balance; }
     std::chrono::system_clock::time_point getLastActivityTime() const { return lastActivityTime; }
-    const std::vector<BankTransaction>& getTransactions() const { return transactions; }
 
-    // Transaction methods
-    void deposit(double amount) {
+    // Reads the history from the store on first use. Returned by value: a later load by
+    // another customer of the same store may release this one.
+    std::vector<BankTransaction> getTransactions() const {
+        loadHistory();
+        return transactions;
+    }
+
+    // Transaction methods; now is the activity time, the owning bank passes its clock's
+    void deposit(double amount,
+                 std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
         if (amount > 0) {
             balance += amount;
-            lastActivityTime = std::chrono::system_clock::now();
+            setLastActivityTime(now);
         }
     }
 
-    bool withdraw(double amount) {
+    bool withdraw(double amount,
+                  std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
         if (amount > 0 && balance >= amount) {
             balance -= amount;
-            lastActivityTime = std::chrono::system_clock::now();
+            setLastActivityTime(now);
             return true;
         }
         return false;
     }
 
     void addTransaction(const BankTransaction& transaction) {
+        loadHistory();
+        historyDirty = true;
         transactions.push_back(transaction);
-        lastActivityTime = std::chrono::system_clock::now();
+        if (historyStore) touchHistory();
+        setLastActivityTime(transaction.getTimestamp());
     }
 
-    // Serialization
-    void serialize(std::ofstream& out) const {
-        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
-
-        int nameLen = name.length();
-        out.write(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
-        out.write(name.c_str(), nameLen);
-
-        int accLen = accountNumber.length();
-        out.write(reinterpret_cast<const char*>(&accLen), sizeof(accLen));
-        out.write(accountNumber.c_str(), accLen);
-
-        out.write(reinterpret_cast<const char*>(&balance), sizeof(balance));
-
-        auto time = lastActivityTime.time_since_epoch().count();
-        out.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    // Heap memory of the customer's own strings; the history is counted separately by
+    // addHistoryUsage()
+    void addHeapUsage(MemoryUsage& usage) const {
+        usage.addString(name);
+        usage.addString(accountNumber);
+    }
 
-        size_t transCount = transactions.size();
-        out.write(reinterpret_cast<const char*>(&transCount), sizeof(transCount));
-        for (const auto& trans : transactions) {
-            trans.serialize(out);
-        }
+    // Heap memory of the resident history only; never loads it
+    void addHistoryUsage(MemoryUsage& usage) const {
+        usage.objects += transactions.size();
+        usage.addVector(transactions);
+        for (const auto& transaction : transactions) transaction.addHeapUsage(usage);
     }
 
-    void deserialize(std::ifstream& in) {
-        in.read(reinterpret_cast<char*>(&id), sizeof(id));
-
-        int nameLen;
-        in.read(reinterpret_cast<char*>(&nameLen), sizeof(nameLen));
-        char* nameBuf = new char[nameLen + 1];
-        in.read(nameBuf, nameLen);
-        nameBuf[nameLen] = '\0';
-        name = nameBuf;
-        delete[] nameBuf;
-
-        int accLen;
-        in.read(reinterpret_cast<char*>(&accLen), sizeof(accLen));
-        char* accBuf = new char[accLen + 1];
-        in.read(accBuf, accLen);
-        accBuf[accLen] = '\0';
-        accountNumber = accBuf;
-        delete[] accBuf;
-
-        in.read(reinterpret_cast<char*>(&balance), sizeof(balance));
-
-        typename std::chrono::system_clock::duration::rep time;
-        in.read(reinterpret_cast<char*>(&time), sizeof(time));
-        lastActivityTime =
-            std::chrono::system_clock::time_point(std::chrono::system_clock::duration(time));
-
-        size_t transCount;
-        in.read(reinterpret_cast<char*>(&transCount), sizeof(transCount));
-        transactions.clear();
-        for (size_t i = 0; i < transCount; i++) {
-            BankTransaction trans;
-            trans.deserialize(in);
-            transactions.push_back(trans);
+    // Serialization. A history the store holds is left out of the record (an empty list);
+    // any other history is written inline as before.
+    void serialize(std::ofstream& out) const {
+        if (!historyStore || historyDirty) {
+            serialization::write(*this, out);
+            return;
         }
+        std::vector<BankTransaction> resident;
+        resident.swap(transactions);
+        serialization::write(*this, out);
+        resident.swap(transactions);
     }
+    void deserialize(std::ifstream& in) { serialization::read(*this, in); }
 };
 
 #endif
\ No newline at end of file
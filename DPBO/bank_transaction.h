@@ -5,6 +5,9 @@
 #include <fstream>
 #include <string>
 
+#include "memory_usage.h"
+#include "serialization.h"
+
 class BankTransaction {
    private:
     int id;
@@ -14,80 +17,51 @@ class BankTransaction {
     std::chrono::system_clock::time_point timestamp;
     std::string description;
 
+    friend struct SerializationAccess;
+
+    static constexpr auto serializationFields() {
+        return std::make_tuple(serialization::raw(&BankTransaction::id),
+                               serialization::string(&BankTransaction::fromAccount),
+                               serialization::string(&BankTransaction::toAccount),
+                               serialization::raw(&BankTransaction::amount),
+                               serialization::time(&BankTransaction::timestamp),
+                               serialization::string(&BankTransaction::description));
+    }
+
    public:
     BankTransaction() : id(0), fromAccount(""), toAccount(""), amount(0.0) {
         timestamp = std::chrono::system_clock::now();
     }
 
-    BankTransaction(int id, std::string from, std::string to, double amount, std::string desc)
-        : id(id), fromAccount(from), toAccount(to), amount(amount), description(desc) {
-        timestamp = std::chrono::system_clock::now();
-    }
+    // Pass the bank clock's time as timestamp so simulated clocks replay deterministically
+    BankTransaction(int id, std::string from, std::string to, double amount, std::string desc,
+                    std::chrono::system_clock::time_point timestamp =
+                        std::chrono::system_clock::now())
+        : id(id),
+          fromAccount(from),
+          toAccount(to),
+          amount(amount),
+          timestamp(timestamp),
+          description(desc) {}
 
     // Getters
     int getId() const { return id; }
-    std::string getFromAccount() const { return fromAccount; }
-    std::string getToAccount() const { return toAccount; }
+    const std::string& getFromAccount() const { return fromAccount; }
+    const std::string& getToAccount() const { return toAccount; }
     double getAmount() const { return amount; }
     std::chrono::system_clock::time_point getTimestamp() const { return timestamp; }
     std::string getDescription() const { return description; }
 
-    // Serialization
-    void serialize(std::ofstream& out) const {
-        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
-
-        int fromLen = fromAccount.length();
-        out.write(reinterpret_cast<const char*>(&fromLen), sizeof(fromLen));
-        out.write(fromAccount.c_str(), fromLen);
-
-        int toLen = toAccount.length();
-        out.write(reinterpret_cast<const char*>(&toLen), sizeof(toLen));
-        out.write(toAccount.c_str(), toLen);
-
-        out.write(reinterpret_cast<const char*>(&amount), sizeof(amount));
-
-        auto time = timestamp.time_since_epoch().count();
-        out.write(reinterpret_cast<const char*>(&time), sizeof(time));
-
-        int descLen = description.length();
-        out.write(reinterpret_cast<const char*>(&descLen), sizeof(descLen));
-        out.write(description.c_str(), descLen);
+    // Heap memory owned by this transaction beyond sizeof(BankTransaction)
+    void addHeapUsage(MemoryUsage& usage) const {
+        usage.addString(fromAccount);
+        usage.addString(toAccount);
+        usage.addString(description);
     }
 
-    void deserialize(std::ifstream& in) {
-        in.read(reinterpret_cast<char*>(&id), sizeof(id));
-
-        int fromLen;
-        in.read(reinterpret_cast<char*>(&fromLen), sizeof(fromLen));
-        char* fromBuf = new char[fromLen + 1];
-        in.read(fromBuf, fromLen);
-        fromBuf[fromLen] = '\0';
-        fromAccount = fromBuf;
-        delete[] fromBuf;
-
-        int toLen;
-        in.read(reinterpret_cast<char*>(&toLen), sizeof(toLen));
-        char* toBuf = new char[toLen + 1];
-        in.read(toBuf, toLen);
-        toBuf[toLen] = '\0';
-        toAccount = toBuf;
-        delete[] toBuf;
-
-        in.read(reinterpret_cast<char*>(&amount), sizeof(amount));
-
-        typename std::chrono::system_clock::duration::rep time;
-        in.read(reinterpret_cast<char*>(&time), sizeof(time));
-        timestamp =
-            std::chrono::system_clock::time_point(std::chrono::system_clock::duration(time));
-
-        int descLen;
-        in.read(reinterpret_cast<char*>(&descLen), sizeof(descLen));
-        char* descBuf = new char[descLen + 1];
-        in.read(descBuf, descLen);
-        descBuf[descLen] = '\0';
-        description = descBuf;
-        delete[] descBuf;
-    }
+    // Serialization
+    void serialize(std::ofstream& out) const { serialization::write(*this, out); }
+    void deserialize(std::ifstream& in) { serialization::read(*this, in); }
 };
 
 #endif
\ No newline at end of file
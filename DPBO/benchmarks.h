@@ -0,0 +1,366 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bank_customer.h"
+#include "bank_transaction.h"
+#include "catalog_index.h"
+#include "checkout_pipeline.h"
+#include "customer_table.h"
+#include "heavy_hitters.h"
+#include "item.h"
+#include "quantile_sketch.h"
+#include "sharded_bank.h"
+#include "stock_lease.h"
+#include "store.h"
+#include "velocity_limiter.h"
+
+// Micro-benchmarks run from batch mode ("bench <name> ..."). Each returns one result line.
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Uniform random transfers between accounts of an in-memory ShardedBank, submitted by one
+// client thread per shard
+inline std::string benchShardedTransfers(size_t shardCount, int accounts, int transfers) {
+    ShardedBank bank(shardCount, "");
+    for (int i = 0; i < accounts; i++) {
+        BankCustomer customer(i, "Customer " + std::to_string(i), "ACC" + std::to_string(i));
+        customer.deposit(1000000.0);
+        bank.addCustomer(customer);
+    }
+    bank.drain();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < shardCount; c++) {
+        clients.emplace_back([&bank, c, shardCount, accounts, transfers] {
+            std::mt19937 random(c);
+            std::uniform_int_distribution<int> pick(0, accounts - 1);
+            std::vector<std::future<bool>> results;
+            for (int i = c; i < transfers; i += shardCount) {
+                BankTransaction transaction(i, "ACC" + std::to_string(pick(random)),
+                                            "ACC" + std::to_string(pick(random)), 1.0, "bench");
+                results.push_back(bank.transfer(transaction));
+            }
+            for (auto& result : results) result.get();
+        });
+    }
+    for (auto& client : clients) client.join();
+    double elapsed = secondsSince(start);
+    bank.drain();
+
+    std::ostringstream line;
+    line << "bench shards " << shardCount << " transfers " << transfers << " elapsed_ms "
+         << elapsed * 1000.0 << " throughput " << (elapsed > 0 ? transfers / elapsed : 0.0)
+         << "/s unacknowledged_credits " << bank.getUnacknowledgedCredits() << "\n";
+    return line.str();
+}
+
+// Threads buying single units of one item of an in-memory Store until it sells out. With
+// leaseChunk > 0 every thread buys through a Store::leaseStock lease of that chunk size,
+// which keeps the store's indexes current, instead of the shared counter.
+inline std::string benchStockContention(int threads, int stock, int leaseChunk) {
+    Store store("");
+    store.addItem(Item(1, "Flash sale item", 1.0, stock));
+    Item& item = *store.findItem(1);
+    std::atomic<long long> purchases(0);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> buyers;
+    for (int t = 0; t < threads; t++) {
+        buyers.emplace_back([&store, &item, &purchases, leaseChunk] {
+            long long bought = 0;
+            if (leaseChunk > 0) {
+                auto lease = store.leaseStock(1, leaseChunk);
+                while (lease->take()) bought++;
+            } else {
+                while (item.decreaseStock(1)) bought++;
+            }
+            purchases.fetch_add(bought);
+        });
+    }
+    for (auto& buyer : buyers) buyer.join();
+    double elapsed = secondsSince(start);
+    if (leaseChunk <= 0) store.onStockChanged(item);
+
+    bool consistent = purchases.load() == stock && item.getSoldCount() == stock &&
+                      item.getStock() == 0 && store.countItemsInPriceRange(0.0, 1.0, true) == 0;
+    std::ostringstream line;
+    line << "bench stock threads " << threads << " lease " << leaseChunk << " purchases "
+         << purchases.load() << " consistent " << (consistent ? "yes" : "no") << " elapsed_ms "
+         << elapsed * 1000.0 << " throughput " << (elapsed > 0 ? purchases.load() / elapsed : 0.0)
+         << "/s\n";
+    return line.str();
+}
+
+// Catalog of random three-word names, then timed substring and prefix queries taken from
+// names in the catalog
+inline std::string benchCatalogSearch(int itemCount, int queries) {
+    std::mt19937 random(42);
+    std::vector<std::string> vocabulary;
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> wordLength(4, 9);
+    for (int i = 0; i < 5000; i++) {
+        std::string word;
+        for (int n = wordLength(random); n > 0; n--) word += static_cast<char>(letter(random));
+        vocabulary.push_back(word);
+    }
+
+    CatalogIndex catalog;
+    std::vector<std::string> names;
+    std::uniform_int_distribution<size_t> pickWord(0, vocabulary.size() - 1);
+    auto buildStart = std::chrono::steady_clock::now();
+    for (int id = 1; id <= itemCount; id++) {
+        std::string name = vocabulary[pickWord(random)] + " " + vocabulary[pickWord(random)] +
+                           " " + vocabulary[pickWord(random)];
+        catalog.add(id, name);
+        if (names.size() < 10000) names.push_back(name);
+    }
+    double buildSeconds = secondsSince(buildStart);
+    if (names.empty()) return "bench search no items\n";
+
+    std::uniform_int_distribution<size_t> pickName(0, names.size() - 1);
+    size_t substringHits = 0, prefixHits = 0;
+    auto substringStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        const std::string& name = names[pickName(random)];
+        substringHits += catalog.substringMatches(name.substr(name.size() / 2, 6), 4096).size();
+    }
+    double substringSeconds = secondsSince(substringStart);
+
+    auto prefixStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        prefixHits += catalog.prefixMatches(names[pickName(random)].substr(0, 3), 4096).size();
+    }
+    double prefixSeconds = secondsSince(prefixStart);
+
+    std::ostringstream line;
+    line << "bench search items " << itemCount << " build_ms " << buildSeconds * 1000.0
+         << " posting_bytes " << catalog.postingBytes() << " substring_us "
+         << (queries > 0 ? substringSeconds * 1e6 / queries : 0.0) << " prefix_us "
+         << (queries > 0 ? prefixSeconds * 1e6 / queries : 0.0) << " hits "
+         << substringHits + prefixHits << "\n";
+    return line.str();
+}
+
+// Velocity checks spread over many accounts, one simulated minute apart
+inline std::string benchVelocityChecks(int accounts, int checks) {
+    VelocityLimiter limiter;
+    limiter.setTierLimits(0, {1000, 1e9});
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> pick(0, accounts - 1);
+    std::vector<uint32_t> picks(checks);
+    for (auto& p : picks) p = pick(random);
+
+    auto now = std::chrono::system_clock::now();
+    size_t allowed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < checks; i++) {
+        auto time = now + std::chrono::minutes(i / accounts);
+        if (limiter.tryConsume(picks[i], 1.0, time)) allowed++;
+    }
+    double elapsed = secondsSince(start);
+
+    std::ostringstream line;
+    line << "bench velocity accounts " << accounts << " checks " << checks << " allowed "
+         << allowed << " ns_per_check " << (checks > 0 ? elapsed * 1e9 / checks : 0.0) << "\n";
+    return line.str();
+}
+
+// Random account lookups in a CustomerTable against the std::map it replaced. The two
+// containers are built one after the other so only one holds the accounts at a time.
+inline std::string benchCustomerLookup(int accounts, int lookups) {
+    std::vector<std::string> accountNumbers;
+    accountNumbers.reserve(accounts);
+    for (int i = 0; i < accounts; i++) accountNumbers.push_back("ACC" + std::to_string(i));
+
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> pick(0, accounts - 1);
+    std::vector<int> picks(lookups);
+    for (auto& p : picks) p = pick(random);
+
+    double mapSeconds = 0.0, tableSeconds = 0.0;
+    size_t found = 0;
+    {
+        std::map<std::string, BankCustomer> customers;
+        for (int i = 0; i < accounts; i++) {
+            customers[accountNumbers[i]] = BankCustomer(i, "Customer", accountNumbers[i]);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int p : picks) found += customers.find(accountNumbers[p]) != customers.end();
+        mapSeconds = secondsSince(start);
+    }
+    {
+        CustomerTable customers;
+        for (int i = 0; i < accounts; i++) {
+            customers.insert(BankCustomer(i, "Customer", accountNumbers[i]));
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int p : picks) found += customers.find(accountNumbers[p]) != nullptr;
+        tableSeconds = secondsSince(start);
+    }
+
+    std::ostringstream line;
+    line << "bench lookup accounts " << accounts << " lookups " << lookups << " found " << found
+         << " map_ns " << (lookups > 0 ? mapSeconds * 1e9 / lookups : 0.0) << " table_ns "
+         << (lookups > 0 ? tableSeconds * 1e9 / lookups : 0.0) << "\n";
+    return line.str();
+}
+
+// Zipf-distributed sales of `items` items spread over 50 minutes, tracked by HeavyHitters
+// and checked against exact counts: how many of the true top 10 are reported, and the
+// largest overcount (signed, so an undercount shows as negative) next to the documented
+// bound. heavy_hitters_check.cpp turns the same comparison into a pass/fail check.
+inline std::string benchTrending(int events, int items) {
+    std::vector<double> weights(items);
+    for (int i = 0; i < items; i++) weights[i] = 1.0 / (i + 1);
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+    std::mt19937 random(13);
+    std::vector<int> picks(events);
+    for (auto& p : picks) p = pick(random);
+
+    HeavyHitters hitters;
+    auto now = std::chrono::system_clock::now();
+    auto begin = now - std::chrono::minutes(50);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < events; i++) {
+        hitters.add(picks[i], begin + std::chrono::microseconds(3000000000LL * i / events));
+    }
+    double elapsed = secondsSince(start);
+    auto top = hitters.top(now, std::chrono::hours(1), 10);
+
+    std::unordered_map<int64_t, uint64_t> exact;
+    for (int p : picks) exact[p]++;
+    std::vector<std::pair<uint64_t, int64_t>> ranked;
+    for (const auto& pair : exact) ranked.emplace_back(pair.second, pair.first);
+    size_t topCount = std::min<size_t>(10, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + topCount, ranked.end(),
+                      [](const std::pair<uint64_t, int64_t>& a,
+                         const std::pair<uint64_t, int64_t>& b) { return a.first > b.first; });
+
+    size_t found = 0;
+    int64_t maxOvercount = top.empty() ? 0 : std::numeric_limits<int64_t>::min();
+    for (const auto& hitter : top) {
+        int64_t overcount =
+            static_cast<int64_t>(hitter.count) - static_cast<int64_t>(exact[hitter.key]);
+        maxOvercount = std::max(maxOvercount, overcount);
+        for (size_t i = 0; i < topCount; i++) found += ranked[i].second == hitter.key;
+    }
+
+    std::ostringstream line;
+    line << "bench trending events " << events << " items " << items << " ns_per_event "
+         << (events > 0 ? elapsed * 1e9 / events : 0.0) << " top10_found " << found
+         << " max_overcount " << maxOvercount << " error_bound "
+         << hitters.errorBound(now, std::chrono::hours(1)) << "\n";
+    return line.str();
+}
+
+// Log-normal amounts sketched by several threads, merged, and compared with the exact
+// quantiles of the sorted values; errors are in rank, as a fraction of the count
+inline std::string benchQuantiles(int values, int threads) {
+    std::vector<double> amounts(values);
+    std::mt19937 random(5);
+    std::lognormal_distribution<double> amount(4.0, 1.0);
+    for (auto& a : amounts) a = amount(random);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<QuantileSketch> sketches(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&amounts, &sketches, t, threads, values] {
+            for (int i = t; i < values; i += threads) sketches[t].add(amounts[i]);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    QuantileSketch merged;
+    for (const auto& sketch : sketches) merged.merge(sketch);
+    double elapsed = secondsSince(start);
+
+    std::sort(amounts.begin(), amounts.end());
+    auto rankError = [&amounts, &merged](double q) {
+        auto rank = std::lower_bound(amounts.begin(), amounts.end(), merged.quantile(q)) -
+                    amounts.begin();
+        return std::abs(static_cast<double>(rank) / amounts.size() - q);
+    };
+
+    std::ostringstream line;
+    line << "bench quantiles values " << values << " threads " << threads << " elapsed_ms "
+         << elapsed * 1000.0 << " retained " << merged.retainedValues() << " p50_err "
+         << rankError(0.5) << " p90_err " << rankError(0.9) << " p99_err " << rankError(0.99)
+         << "\n";
+    return line.str();
+}
+
+// Checkouts of random buyers against one seller, through a CheckoutPipeline over an
+// in-memory Bank and Store. All checkouts are submitted up front, so latency, from submit()
+// to the delivered result, includes the time spent queued
+inline std::string benchCheckout(int checkouts, int buyerCount, int batch) {
+    Bank bank("");
+    Store store("");
+    bank.addCustomer(BankCustomer(bank.nextCustomerId(), "Seller", "S0"));
+    Seller seller(1, "Seller");
+    seller.createBankAccount(bank.findCustomer("S0"));
+    store.addSeller(seller);
+    for (int i = 0; i < buyerCount; i++) {
+        std::string account = "B" + std::to_string(i);
+        bank.addCustomer(BankCustomer(bank.nextCustomerId(), account, account));
+        bank.findCustomer(account)->deposit(1e12);
+        Buyer buyer(i + 1, account);
+        buyer.createBankAccount(bank.findCustomer(account));
+        store.addBuyer(buyer);
+    }
+    store.addItem(Item(1, "Widget", 1.0, checkouts));
+
+    std::mt19937 random(13);
+    std::uniform_int_distribution<int> pick(1, buyerCount);
+    std::vector<std::future<CheckoutResult>> pending;
+    pending.reserve(checkouts);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        CheckoutPipeline pipeline(store, bank, static_cast<size_t>(batch));
+        for (int i = 0; i < checkouts; i++) {
+            pending.push_back(pipeline.submit({pick(random), 1, 1, 1}));
+        }
+    }
+    double elapsed = secondsSince(start);
+
+    std::vector<double> latencies;
+    latencies.reserve(checkouts);
+    size_t succeeded = 0;
+    for (auto& result : pending) {
+        CheckoutResult checkout = result.get();
+        if (checkout.success) succeeded++;
+        latencies.push_back(checkout.latencyMicros);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double q) {
+        if (latencies.empty()) return 0.0;
+        return latencies[static_cast<size_t>(q * (latencies.size() - 1))];
+    };
+
+    std::ostringstream line;
+    line << "bench checkout checkouts " << checkouts << " buyers " << buyerCount << " batch "
+         << batch << " succeeded " << succeeded << " throughput "
+         << (elapsed > 0 ? checkouts / elapsed : 0.0) << "/s latency_us p50 " << percentile(0.5)
+         << " p99 " << percentile(0.99) << "\n";
+    return line.str();
+}
+
+#endif
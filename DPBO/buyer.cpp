@@ -27,13 +27,14 @@ bool Buyer::withdraw(double amount) {
     return false;
 }
 
-void Buyer::addTransaction(const Transaction& transaction) { transactions.push_back(transaction); }
+void Buyer::addTransaction(const Transaction& transaction) {
+    transactionPositions[transaction.getId()] = transactions.size();
+    transactions.push_back(transaction);
+    statusIndex.add(transaction.getStatus());
+}
 
 std::vector<Transaction> Buyer::getTransactions(TransactionStatus status) const {
-    std::vector<Transaction> filtered;
-    std::copy_if(transactions.begin(), transactions.end(), std::back_inserter(filtered),
-                 [status](const Transaction& t) { return t.getStatus() == status; });
-    return filtered;
+    return transactionsView(status).toVector();
 }
 
 double Buyer::getTotalSpending(int days) const {
@@ -41,7 +42,7 @@ double Buyer::getTotalSpending(int days) const {
     auto now = std::chrono::system_clock::now();
 
     for (const auto& transaction : transactions) {
-        if (transaction.isWithinDays(days) &&
+        if (transaction.isWithinDays(days, now) &&
             transaction.getStatus() != TransactionStatus::CANCELED) {
             total += transaction.getAmount();
         }
@@ -4,16 +4,21 @@
 #include <chrono>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "bank_customer.h"
+#include "query_view.h"
 #include "transaction.h"
+#include "transaction_status_index.h"
 #include "user.h"
 
 class Buyer : public User {
    private:
     BankCustomer* bankAccount;
     std::vector<Transaction> transactions;
+    TransactionStatusIndex statusIndex;
+    std::unordered_map<int, size_t> transactionPositions;
 
    public:
     Buyer() : User(), bankAccount(nullptr) {}
@@ -24,6 +29,7 @@ class Buyer : public User {
     void createBankAccount(BankCustomer* account) { this->bankAccount = account; }
 
     bool hasBankAccount() const { return bankAccount != nullptr; }
+    const BankCustomer* getBankAccount() const { return bankAccount; }
 
     // Money management
     bool deposit(double amount) {
@@ -45,13 +51,32 @@ class Buyer : public User {
     double getBalance() const { return bankAccount ? bankAccount->getBalance() : 0.0; }
 
     // Transaction management
-    void addTransaction(const Transaction& transaction) { transactions.push_back(transaction); }
+    void addTransaction(const Transaction& transaction) {
+        transactionPositions[transaction.getId()] = transactions.size();
+        transactions.push_back(transaction);
+        statusIndex.add(transaction.getStatus());
+    }
+
+    bool updateTransactionStatus(int transactionId, TransactionStatus status) {
+        auto it = transactionPositions.find(transactionId);
+        if (it == transactionPositions.end()) return false;
+        transactions[it->second].setStatus(status);
+        statusIndex.setStatus(it->second, status);
+        return true;
+    }
+
+    // Lazy views over the buyer's transactions
+    auto transactionsView() const {
+        return makeQueryView(transactions.begin(), transactions.end());
+    }
+
+    auto transactionsView(TransactionStatus status) const {
+        return makeQueryView(statusIndex.begin(status), statusIndex.end(),
+                             PositionProjection<std::vector<Transaction>>{&transactions});
+    }
 
     std::vector<Transaction> getTransactions(TransactionStatus status) const {
-        std::vector<Transaction> filtered;
-        std::copy_if(transactions.begin(), transactions.end(), std::back_inserter(filtered),
-                     [status](const Transaction& t) { return t.getStatus() == status; });
-        return filtered;
+        return transactionsView(status).toVector();
     }
 
     double getTotalSpending(int days) const {
@@ -59,7 +84,7 @@ class Buyer : public User {
         auto now = std::chrono::system_clock::now();
 
         for (const auto& transaction : transactions) {
-            if (transaction.isWithinDays(days) &&
+            if (transaction.isWithinDays(days, now) &&
                 transaction.getStatus() != TransactionStatus::CANCELED) {
                 total += transaction.getAmount();
             }
@@ -94,6 +119,13 @@ class Buyer : public User {
         return flow;
     }
 
+    // Memory held by the buyer beyond sizeof(Buyer)
+    void addMemoryUsage(MemoryUsage& usage) const {
+        addHeapUsage(usage);
+        usage.addVector(transactions);
+        usage.addHashMap(transactionPositions);
+    }
+
     // Override base class methods
     std::string getInfo() const override {
         std::string info = User::getInfo();
@@ -0,0 +1,265 @@
+#ifndef CATALOG_INDEX_H
+#define CATALOG_INDEX_H
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Sorted item ids, delta-encoded as variable-length integers.
+// Ids usually arrive in increasing order, so adding one is an append; anything else
+// re-encodes the list.
+class PostingList {
+   private:
+    std::vector<uint8_t> bytes;
+    int lastId = 0;
+    size_t count = 0;
+
+    static void appendVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void encode(const std::vector<int>& ids) {
+        bytes.clear();
+        lastId = 0;
+        for (int id : ids) {
+            appendVarint(bytes, static_cast<uint32_t>(id - lastId));
+            lastId = id;
+        }
+        count = ids.size();
+    }
+
+   public:
+    template <typename Function>
+    void forEach(Function function) const {
+        int id = 0;
+        size_t i = 0;
+        while (i < bytes.size()) {
+            uint32_t delta = 0;
+            int shift = 0;
+            while (bytes[i] & 0x80) {
+                delta |= static_cast<uint32_t>(bytes[i++] & 0x7F) << shift;
+                shift += 7;
+            }
+            delta |= static_cast<uint32_t>(bytes[i++]) << shift;
+            id += static_cast<int>(delta);
+            function(id);
+        }
+    }
+
+    std::vector<int> decode() const {
+        std::vector<int> ids;
+        ids.reserve(count);
+        forEach([&ids](int id) { ids.push_back(id); });
+        return ids;
+    }
+
+    void add(int id) {
+        if (count == 0 || id > lastId) {
+            appendVarint(bytes, static_cast<uint32_t>(id - lastId));
+            lastId = id;
+            count++;
+            return;
+        }
+        std::vector<int> ids = decode();
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it != ids.end() && *it == id) return;
+        ids.insert(it, id);
+        encode(ids);
+    }
+
+    void remove(int id) {
+        std::vector<int> ids = decode();
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it == ids.end() || *it != id) return;
+        ids.erase(it);
+        encode(ids);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t byteSize() const { return bytes.size(); }
+};
+
+// Search index over item names, kept in sync by the Store on addItem and renameItem.
+// Names are matched case-insensitively. Autocomplete uses an ordered set of (word, id)
+// so every word of a name can be completed; substring and fuzzy matching use a trigram
+// index whose posting lists are PostingLists. Queries return candidate ids only; the
+// Store ranks them by soldCount.
+class CatalogIndex {
+   private:
+    std::unordered_map<int, std::string> names;  // normalized name per item id
+    std::set<std::pair<std::string, int>> words;
+    std::unordered_map<uint32_t, PostingList> postings;
+
+    static std::string normalize(const std::string& text) {
+        std::string normalized(text);
+        for (char& c : normalized) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return normalized;
+    }
+
+    static std::vector<std::string> splitWords(const std::string& text) {
+        std::vector<std::string> result;
+        std::string word;
+        for (char c : text) {
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                word += c;
+            } else if (!word.empty()) {
+                result.push_back(word);
+                word.clear();
+            }
+        }
+        if (!word.empty()) result.push_back(word);
+        return result;
+    }
+
+    // Distinct trigrams of text, three bytes packed into one integer
+    static std::vector<uint32_t> trigrams(const std::string& text) {
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            result.push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                             static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                             static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2])));
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+   public:
+    void add(int itemId, const std::string& name) {
+        remove(itemId);
+        std::string normalized = normalize(name);
+        for (const auto& word : splitWords(normalized)) words.insert({word, itemId});
+        for (uint32_t trigram : trigrams(normalized)) postings[trigram].add(itemId);
+        names[itemId] = normalized;
+    }
+
+    void remove(int itemId) {
+        auto it = names.find(itemId);
+        if (it == names.end()) return;
+        for (const auto& word : splitWords(it->second)) words.erase({word, itemId});
+        for (uint32_t trigram : trigrams(it->second)) {
+            auto posting = postings.find(trigram);
+            if (posting == postings.end()) continue;
+            posting->second.remove(itemId);
+            if (posting->second.empty()) postings.erase(posting);
+        }
+        names.erase(it);
+    }
+
+    void rename(int itemId, const std::string& name) { add(itemId, name); }
+
+    // Runs visit(id) for every item with a word starting with prefix, in word order; an
+    // item with several such words is visited once per word. Stops when visit returns false.
+    template <typename Visit>
+    void forEachPrefixMatch(const std::string& prefix, Visit visit) const {
+        std::string normalized = normalize(prefix);
+        for (auto it = words.lower_bound({normalized, INT_MIN});
+             it != words.end() && it->first.compare(0, normalized.size(), normalized) == 0;
+             ++it) {
+            if (!visit(it->second)) return;
+        }
+    }
+
+    // Runs visit(id) for every item whose name contains text, in id order. The posting
+    // lists of the query trigrams are intersected shortest first, and the survivors are
+    // checked against the stored name. Stops when visit returns false.
+    template <typename Visit>
+    void forEachSubstringMatch(const std::string& text, Visit visit) const {
+        std::string normalized = normalize(text);
+        std::vector<uint32_t> queryTrigrams = trigrams(normalized);
+        if (queryTrigrams.empty()) return forEachPrefixMatch(normalized, visit);
+
+        std::vector<const PostingList*> lists;
+        for (uint32_t trigram : queryTrigrams) {
+            auto it = postings.find(trigram);
+            if (it == postings.end()) return;
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+            return a->size() < b->size();
+        });
+
+        std::vector<int> candidates = lists[0]->decode();
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+            std::vector<int> next;
+            auto candidate = candidates.begin();
+            lists[i]->forEach([&](int id) {
+                while (candidate != candidates.end() && *candidate < id) ++candidate;
+                if (candidate != candidates.end() && *candidate == id) next.push_back(id);
+            });
+            candidates.swap(next);
+        }
+
+        for (int id : candidates) {
+            if (names.at(id).find(normalized) != std::string::npos && !visit(id)) return;
+        }
+    }
+
+    // The first maxCandidates distinct items of forEachPrefixMatch(), in id order
+    std::vector<int> prefixMatches(const std::string& prefix, size_t maxCandidates) const {
+        std::vector<int> ids;
+        forEachPrefixMatch(prefix, [&ids, maxCandidates](int id) {
+            if (ids.size() >= maxCandidates) return false;
+            ids.push_back(id);
+            return true;
+        });
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+
+    // The first maxCandidates items of forEachSubstringMatch(), in id order
+    std::vector<int> substringMatches(const std::string& text, size_t maxCandidates) const {
+        std::vector<int> ids;
+        forEachSubstringMatch(text, [&ids, maxCandidates](int id) {
+            if (ids.size() >= maxCandidates) return false;
+            ids.push_back(id);
+            return true;
+        });
+        return ids;
+    }
+
+    // Items sharing at least minSimilarity of the query's trigrams, as (id, shared count)
+    std::vector<std::pair<int, int>> fuzzyMatches(const std::string& text,
+                                                  double minSimilarity = 0.5) const {
+        std::vector<uint32_t> queryTrigrams = trigrams(normalize(text));
+        std::vector<std::pair<int, int>> matches;
+        if (queryTrigrams.empty()) return matches;
+
+        std::unordered_map<int, int> shared;
+        for (uint32_t trigram : queryTrigrams) {
+            auto it = postings.find(trigram);
+            if (it == postings.end()) continue;
+            it->second.forEach([&shared](int id) { shared[id]++; });
+        }
+
+        int required = std::max(1, static_cast<int>(minSimilarity * queryTrigrams.size() + 0.5));
+        for (const auto& pair : shared) {
+            if (pair.second >= required) matches.push_back(pair);
+        }
+        return matches;
+    }
+
+    size_t size() const { return names.size(); }
+
+    size_t postingBytes() const {
+        size_t total = 0;
+        for (const auto& pair : postings) total += pair.second.byteSize();
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "checkout_pipeline.h"
+
+#include <string>
+#include <utility>
+
+void CheckoutPipeline::BatchQueue::push(std::vector<Job>&& batch) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.push_back(std::move(batch));
+    }
+    ready.notify_one();
+}
+
+bool CheckoutPipeline::BatchQueue::pop(std::vector<Job>& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [this] { return closed || !batches.empty(); });
+    if (batches.empty()) return false;
+    batch = std::move(batches.front());
+    batches.pop_front();
+    return true;
+}
+
+void CheckoutPipeline::BatchQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    ready.notify_one();
+}
+
+CheckoutPipeline::CheckoutPipeline(Store& store, Bank& bank, size_t maxBatch)
+    : store(store),
+      bank(bank),
+      maxBatch(maxBatch > 0 ? maxBatch : 1),
+      paymentIds(bank.getIdSequence(), SequenceKind::TRANSACTION),
+      transactionIds(store.getIdSequence(), SequenceKind::TRANSACTION),
+      stopping(false) {
+    reserver = std::thread(&CheckoutPipeline::runReserve, this);
+    charger = std::thread(&CheckoutPipeline::runCharge, this);
+    committer = std::thread(&CheckoutPipeline::runCommit, this);
+}
+
+// Each stage closes the next one's queue once it has drained its own input
+CheckoutPipeline::~CheckoutPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_one();
+    reserver.join();
+    charger.join();
+    committer.join();
+}
+
+std::future<CheckoutResult> CheckoutPipeline::submit(const CheckoutRequest& request) {
+    Job job;
+    job.request = request;
+    job.submitted = std::chrono::steady_clock::now();
+    auto result = job.result.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(job));
+    }
+    queueReady.notify_one();
+    return result;
+}
+
+void CheckoutPipeline::runReserve() {
+    while (true) {
+        std::vector<Job> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) break;  // stopping and fully drained
+
+            while (!queue.empty() && batch.size() < maxBatch) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        reserveStage(batch);
+        chargeQueue.push(std::move(batch));
+    }
+    chargeQueue.close();
+}
+
+void CheckoutPipeline::runCharge() {
+    std::vector<Job> batch;
+    while (chargeQueue.pop(batch)) {
+        chargeStage(batch);
+        commitQueue.push(std::move(batch));
+    }
+    commitQueue.close();
+}
+
+void CheckoutPipeline::runCommit() {
+    std::vector<Job> batch;
+    while (commitQueue.pop(batch)) commitStage(batch);
+}
+
+// Stage 1: validate the request and take the stock out of the catalog
+void CheckoutPipeline::reserveStage(std::vector<Job>& batch) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    for (auto& job : batch) {
+        const CheckoutRequest& request = job.request;
+        job.buyer = store.findBuyer(request.buyerId);
+        Seller* seller = store.findSeller(request.sellerId);
+        Item* item = store.findItem(request.itemId);
+
+        if (!job.buyer || !job.buyer->hasBankAccount()) {
+            job.failed = true;
+            job.reason = "unknown buyer";
+        } else if (!seller || !seller->hasBankAccount()) {
+            job.failed = true;
+            job.reason = "unknown seller";
+        } else if (!item) {
+            job.failed = true;
+            job.reason = "unknown item";
+        } else if (!store.reserveStock(request.itemId, request.quantity)) {
+            job.failed = true;
+            job.reason = "out of stock";
+        } else {
+            job.reserved = true;
+            job.amount = item->getPrice() * request.quantity;
+            job.fromAccount = job.buyer->getBankAccount()->getAccountNumber();
+            job.toAccount = seller->getBankAccount()->getAccountNumber();
+        }
+    }
+}
+
+// Stage 2: pay the seller from the buyer's account; a refused transfer fails the checkout
+void CheckoutPipeline::chargeStage(std::vector<Job>& batch) {
+    for (auto& job : batch) {
+        if (job.failed) continue;
+        BankTransaction payment(paymentIds.next(), job.fromAccount, job.toAccount,
+                                job.amount, "checkout item " + std::to_string(job.request.itemId),
+                                bank.getClock().now());
+        if (!bank.processTransaction(payment)) {
+            job.failed = true;
+            job.reason = "payment refused";
+        }
+    }
+}
+
+// Stage 3: record the paid transactions, return the stock of failed charges and deliver
+// every result of the batch
+void CheckoutPipeline::commitStage(std::vector<Job>& batch) {
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        for (auto& job : batch) {
+            const CheckoutRequest& request = job.request;
+            if (job.failed) {
+                if (job.reserved) store.releaseStock(request.itemId, request.quantity);
+                continue;
+            }
+            Transaction transaction(transactionIds.next(), request.buyerId, request.sellerId,
+                                    request.itemId, job.amount, store.getClock().now());
+            transaction.setQuantity(request.quantity);
+            transaction.setStatus(TransactionStatus::PAID);
+            store.commitTransaction(transaction);
+            job.buyer->addTransaction(transaction);
+            if (Seller* seller = store.findSeller(request.sellerId)) {
+                seller->addTransaction(transaction);
+            }
+            job.transactionId = transaction.getId();
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& job : batch) {
+        CheckoutResult result{!job.failed, job.transactionId, job.reason, 0.0};
+        result.latencyMicros =
+            std::chrono::duration<double, std::micro>(now - job.submitted).count();
+        job.result.set_value(result);
+    }
+}
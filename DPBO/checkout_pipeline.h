@@ -0,0 +1,110 @@
+#ifndef CHECKOUT_PIPELINE_H
+#define CHECKOUT_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bank.h"
+#include "id_sequence.h"
+#include "store.h"
+
+struct CheckoutRequest {
+    int buyerId;
+    int sellerId;
+    int itemId;
+    int quantity;
+};
+
+struct CheckoutResult {
+    bool success;
+    int transactionId;
+    std::string reason;
+    double latencyMicros;
+};
+
+// Asynchronous checkout that chains a Store purchase with a bank payment from the buyer's
+// account to the seller's. submit() only queues the request. Three stage threads run
+// one after the other on batches of up to maxBatch checkouts, handing each batch on through
+// a queue, so while one batch is being charged the next is reserving stock and the previous
+// one is committing:
+//   reserve  validates the request, takes the stock out of the catalog (Store)
+//   charge   transfers the amount with Bank::processTransaction, which writes the
+//            BankTransaction and enforces velocity limits (Bank)
+//   commit   records the paid transaction, or returns the stock of a failed charge (Store)
+// The reserve and commit stages share the Store under storeMutex; only the charge stage
+// touches the Bank. While a pipeline is running it is the only writer of the Store and the
+// Bank; callers must not modify them concurrently.
+class CheckoutPipeline {
+   private:
+    struct Job {
+        CheckoutRequest request;
+        std::chrono::steady_clock::time_point submitted;
+        std::promise<CheckoutResult> result;
+        Buyer* buyer = nullptr;
+        std::string fromAccount;
+        std::string toAccount;
+        double amount = 0.0;
+        bool reserved = false;
+        bool failed = false;
+        std::string reason;
+        int transactionId = 0;
+    };
+
+    // Hands batches from one stage thread to the next
+    class BatchQueue {
+       private:
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::vector<Job>> batches;
+        bool closed = false;
+
+       public:
+        void push(std::vector<Job>&& batch);
+        // Waits for a batch; false once the queue is closed and drained
+        bool pop(std::vector<Job>& batch);
+        void close();
+    };
+
+    Store& store;
+    Bank& bank;
+    size_t maxBatch;
+    std::mutex storeMutex;
+    // Ids are taken a block at a time, so the stages rarely touch the shared counters
+    IdBlock paymentIds;      // charge stage
+    IdBlock transactionIds;  // commit stage
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<Job> queue;
+    bool stopping;
+    BatchQueue chargeQueue;
+    BatchQueue commitQueue;
+    std::thread reserver;
+    std::thread charger;
+    std::thread committer;
+
+    void runReserve();
+    void runCharge();
+    void runCommit();
+    void reserveStage(std::vector<Job>& batch);
+    void chargeStage(std::vector<Job>& batch);
+    void commitStage(std::vector<Job>& batch);
+
+   public:
+    CheckoutPipeline(Store& store, Bank& bank, size_t maxBatch = 256);
+    CheckoutPipeline(const CheckoutPipeline&) = delete;
+    CheckoutPipeline& operator=(const CheckoutPipeline&) = delete;
+
+    // Finishes every submitted checkout before returning
+    ~CheckoutPipeline();
+
+    std::future<CheckoutResult> submit(const CheckoutRequest& request);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Time source injected into Bank and Store.
+// Queries read now() once and compare every record against that single value.
+class Clock {
+   public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    virtual TimePoint now() const = 0;
+    virtual ~Clock() = default;
+};
+
+// Reads the system clock on every call
+class SystemClock : public Clock {
+   public:
+    TimePoint now() const override { return std::chrono::system_clock::now(); }
+
+    static const SystemClock& instance() {
+        static SystemClock clock;
+        return clock;
+    }
+};
+
+// Serves a cached system time that a background thread refreshes every resolution.
+// now() is a single atomic load, at the cost of being up to one resolution behind.
+class CoarseClock : public Clock {
+   private:
+    std::atomic<std::chrono::system_clock::rep> cached;
+    std::atomic<bool> running;
+    std::chrono::milliseconds resolution;
+    std::thread ticker;
+
+    void refresh() {
+        cached.store(std::chrono::system_clock::now().time_since_epoch().count(),
+                     std::memory_order_relaxed);
+    }
+
+   public:
+    explicit CoarseClock(std::chrono::milliseconds resolution = std::chrono::milliseconds(10))
+        : running(true), resolution(resolution) {
+        refresh();
+        ticker = std::thread([this] {
+            while (running.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(this->resolution);
+                refresh();
+            }
+        });
+    }
+
+    CoarseClock(const CoarseClock&) = delete;
+    CoarseClock& operator=(const CoarseClock&) = delete;
+
+    ~CoarseClock() override {
+        running.store(false);
+        ticker.join();
+    }
+
+    TimePoint now() const override {
+        auto ticks = cached.load(std::memory_order_relaxed);
+        return TimePoint(std::chrono::system_clock::duration(ticks));
+    }
+};
+
+// Time that only moves when told to, for benchmarks and deterministic replays
+class SimulatedClock : public Clock {
+   private:
+    std::atomic<std::chrono::system_clock::rep> current;
+
+   public:
+    SimulatedClock() : current(std::chrono::system_clock::now().time_since_epoch().count()) {}
+
+    explicit SimulatedClock(TimePoint start) : current(start.time_since_epoch().count()) {}
+
+    TimePoint now() const override {
+        return TimePoint(std::chrono::system_clock::duration(current.load()));
+    }
+
+    void set(TimePoint time) { current.store(time.time_since_epoch().count()); }
+
+    void advance(std::chrono::system_clock::duration step) { current.fetch_add(step.count()); }
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef CUSTOMER_HISTORY_H
+#define CUSTOMER_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bank_transaction.h"
+#include "memory_usage.h"
+
+class BankCustomer;
+
+// Where one customer's history sits in a HistoryStore file
+struct HistoryLocation {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+};
+
+// Customer transaction histories kept out of memory.
+// Histories live in one append-only file, each as a contiguous run of records; a customer
+// keeps only the location of its run and reads it on first use. Resident histories are
+// kept in LRU order and the least recently used are released while more than
+// maxResidentRecords records are resident. A history changed since it was read is
+// appended again under a new location when it is released or saved; its old run stays in
+// the file as garbage until compact() rewrites the file with only the live runs.
+// The store is not thread-safe, like the bank that owns it.
+class HistoryStore {
+   public:
+    static constexpr size_t DEFAULT_RESIDENT_RECORDS = size_t(1) << 20;
+    // Share of dead records in the file above which needsCompaction() asks for a rewrite
+    static constexpr double MAX_GARBAGE_RATIO = 0.5;
+
+   private:
+    using Entry = std::pair<const BankCustomer*, size_t>;  // customer, resident records
+
+    std::string fileName;
+    size_t maxResidentRecords;
+    size_t residentRecords = 0;
+    uint64_t fileRecords = 0;  // records in the file, live or not
+    std::list<Entry> lru;      // most recently used first
+    std::unordered_map<const BankCustomer*, std::list<Entry>::iterator> positions;
+
+    static std::vector<BankTransaction> readRun(std::ifstream& file,
+                                                const HistoryLocation& location) {
+        std::vector<BankTransaction> records;
+        if (location.count == 0) return records;
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(location.offset));
+        records.reserve(location.count);
+        for (uint64_t i = 0; i < location.count && file; i++) {
+            BankTransaction record;
+            record.deserialize(file);
+            if (file) records.push_back(record);
+        }
+        return records;
+    }
+
+   public:
+    explicit HistoryStore(std::string fileName,
+                          size_t maxResidentRecords = DEFAULT_RESIDENT_RECORDS)
+        : fileName(std::move(fileName)), maxResidentRecords(maxResidentRecords) {}
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    // Reads the run at location; an unreadable run reads as the records before the failure
+    std::vector<BankTransaction> read(const HistoryLocation& location) const {
+        if (location.count == 0) return {};
+        std::ifstream file(fileName, std::ios::binary);
+        return readRun(file, location);
+    }
+
+    // Appends a run at the end of the file; an empty history needs no run, and a store
+    // without a file keeps every history resident
+    HistoryLocation append(const std::vector<BankTransaction>& records) {
+        HistoryLocation location;
+        if (records.empty() || fileName.empty()) return location;
+        std::ofstream file(fileName, std::ios::binary | std::ios::app);
+        if (!file.is_open()) return location;
+        file.seekp(0, std::ios::end);
+        location.offset = static_cast<uint64_t>(file.tellp());
+        for (const auto& record : records) record.serialize(file);
+        file.close();
+        if (file) location.count = records.size();
+        fileRecords += location.count;
+        return location;
+    }
+
+    // Whether dead runs take more than MAX_GARBAGE_RATIO of the file, given the number of
+    // records the live locations cover
+    bool needsCompaction(uint64_t liveRecords) const {
+        return !fileName.empty() && fileRecords > liveRecords &&
+               fileRecords - liveRecords > MAX_GARBAGE_RATIO * fileRecords;
+    }
+
+    // Rewrites the file with only the given runs, through a temporary file, and moves each
+    // location to its new place. Returns false, leaving file and locations as they were,
+    // when the rewrite fails.
+    bool compact(std::vector<HistoryLocation>& locations) {
+        std::ifstream in(fileName, std::ios::binary);
+        std::string temporary = fileName + ".tmp";
+        std::ofstream out(temporary, std::ios::binary);
+        if (!in.is_open() || !out.is_open()) return false;
+
+        std::vector<HistoryLocation> moved(locations.size());
+        uint64_t records = 0;
+        for (size_t i = 0; i < locations.size(); i++) {
+            std::vector<BankTransaction> run = readRun(in, locations[i]);
+            if (run.size() != locations[i].count) break;
+            moved[i].offset = static_cast<uint64_t>(out.tellp());
+            moved[i].count = run.size();
+            for (const auto& record : run) record.serialize(out);
+            records += run.size();
+        }
+        out.close();
+        in.close();
+        uint64_t expected = 0;
+        for (const auto& location : locations) expected += location.count;
+        if (!out || records != expected ||
+            std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        locations.swap(moved);
+        fileRecords = records;
+        return true;
+    }
+
+    // Marks a resident history as most recently used; returns the histories to release to
+    // get back under the limit, never the one just used
+    std::vector<const BankCustomer*> touch(const BankCustomer* customer, size_t records) {
+        forget(customer);
+        lru.emplace_front(customer, records);
+        positions[customer] = lru.begin();
+        residentRecords += records;
+
+        std::vector<const BankCustomer*> released;
+        while (residentRecords > maxResidentRecords && lru.size() > 1) {
+            released.push_back(lru.back().first);
+            forget(lru.back().first);
+        }
+        return released;
+    }
+
+    // Stops tracking a history that was released, changed or destroyed
+    void forget(const BankCustomer* customer) {
+        auto it = positions.find(customer);
+        if (it == positions.end()) return;
+        residentRecords -= it->second->second;
+        lru.erase(it->second);
+        positions.erase(it);
+    }
+
+    void setMaxResidentRecords(size_t records) { maxResidentRecords = records; }
+    size_t getMaxResidentRecords() const { return maxResidentRecords; }
+    size_t getResidentRecords() const { return residentRecords; }
+    size_t getResidentHistories() const { return lru.size(); }
+    const std::string& getFileName() const { return fileName; }
+    // Persisted by the owning bank, so the garbage share survives restarts
+    uint64_t getFileRecords() const { return fileRecords; }
+    void setFileRecords(uint64_t records) { fileRecords = records; }
+
+    // The LRU bookkeeping; resident records are counted by their customers
+    void addMemoryUsage(MemoryUsage& usage) const {
+        usage.objects += lru.size();
+        usage.bytes += lru.size() * (sizeof(Entry) + 2 * sizeof(void*));
+        usage.addHashMap(positions);
+    }
+};
+
+#endif
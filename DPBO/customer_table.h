@@ -0,0 +1,121 @@
+#ifndef CUSTOMER_TABLE_H
+#define CUSTOMER_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bank_customer.h"
+
+// Bank customers keyed by account number.
+// Customers live contiguously in a deque, which never moves an element once added, so
+// references handed out (e.g. Buyer::bankAccount) stay valid. The lookup side is a flat
+// open-addressing table of 8-byte slots: 32 bits of the hash as a tag plus the position of
+// the customer. A probe compares tags first and only touches the customer on a tag match.
+// Lookups take a string_view, so callers never build a temporary std::string.
+// Iteration is in insertion order.
+class CustomerTable {
+   private:
+    struct Slot {
+        uint32_t tag = 0;
+        uint32_t position = 0;  // 1-based index into customers; 0 marks an empty slot
+    };
+
+    std::deque<BankCustomer> customers;
+    std::vector<Slot> slots;
+
+    static size_t hashOf(std::string_view accountNumber) {
+        return std::hash<std::string_view>()(accountNumber);
+    }
+
+    static uint32_t tagOf(size_t hash) { return static_cast<uint32_t>(hash >> 32) | 1u; }
+
+    // Slot holding accountNumber, or the empty slot where it would go
+    size_t probe(std::string_view accountNumber, size_t hash) const {
+        size_t mask = slots.size() - 1;
+        uint32_t tag = tagOf(hash);
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.position == 0) return i;
+            if (slot.tag == tag &&
+                customers[slot.position - 1].getAccountNumber() == accountNumber) {
+                return i;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> previous;
+        previous.swap(slots);
+        slots.resize(previous.empty() ? 16 : previous.size() * 2);
+        size_t mask = slots.size() - 1;
+        for (const auto& slot : previous) {
+            if (slot.position == 0) continue;
+            size_t hash = hashOf(customers[slot.position - 1].getAccountNumber());
+            size_t i = hash & mask;
+            while (slots[i].position != 0) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+
+   public:
+    using iterator = std::deque<BankCustomer>::iterator;
+    using const_iterator = std::deque<BankCustomer>::const_iterator;
+
+    BankCustomer* find(std::string_view accountNumber) {
+        if (slots.empty()) return nullptr;
+        const Slot& slot = slots[probe(accountNumber, hashOf(accountNumber))];
+        return slot.position != 0 ? &customers[slot.position - 1] : nullptr;
+    }
+
+    const BankCustomer* find(std::string_view accountNumber) const {
+        return const_cast<CustomerTable*>(this)->find(accountNumber);
+    }
+
+    bool contains(std::string_view accountNumber) const { return find(accountNumber) != nullptr; }
+
+    // Position of the customer in insertion order, or NPOS; stable for the table's lifetime
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+    size_t indexOf(std::string_view accountNumber) const {
+        if (slots.empty()) return NPOS;
+        const Slot& slot = slots[probe(accountNumber, hashOf(accountNumber))];
+        return slot.position != 0 ? slot.position - 1 : NPOS;
+    }
+
+    BankCustomer& at(size_t index) { return customers[index]; }
+
+    // Adds the customer unless the account number is taken, with a single probe.
+    // Returns the stored customer and whether it was added.
+    std::pair<BankCustomer*, bool> insert(const BankCustomer& customer) {
+        if ((customers.size() + 1) * 4 > slots.size() * 3) grow();
+
+        size_t hash = hashOf(customer.getAccountNumber());
+        Slot& slot = slots[probe(customer.getAccountNumber(), hash)];
+        if (slot.position != 0) return {&customers[slot.position - 1], false};
+
+        customers.push_back(customer);
+        slot.tag = tagOf(hash);
+        slot.position = static_cast<uint32_t>(customers.size());
+        return {&customers.back(), true};
+    }
+
+    size_t size() const { return customers.size(); }
+    size_t slotBytes() const { return slots.capacity() * sizeof(Slot); }
+    bool empty() const { return customers.empty(); }
+
+    void clear() {
+        customers.clear();
+        slots.clear();
+    }
+
+    iterator begin() { return customers.begin(); }
+    iterator end() { return customers.end(); }
+    const_iterator begin() const { return customers.begin(); }
+    const_iterator end() const { return customers.end(); }
+};
+
+#endif
@@ -0,0 +1,591 @@
+// Standalone exporter for offline analysis.
+// Streams records straight out of bank_data.bin or store_data.bin, one record in memory
+// at a time, without constructing a Bank or Store (whose destructors rewrite the files).
+// Transactions sealed into ledger segments are read from the segment files listed in the
+// data file, looked up next to it; segments outside the time range are skipped.
+//
+// Build: g++ -std=c++17 -O2 exporter.cpp -o exporter
+// Usage: exporter bank|store <data file> <output prefix> [--format csv|columnar|both]
+//                 [--from <epoch seconds>] [--to <epoch seconds>] [--account <account>]
+//
+// Each table goes to <prefix>_<table>.csv and/or <prefix>_<table>.col. The time range
+// applies to transactions and order lines; --account keeps the records of one bank account
+// (bank) or one buyer/seller id (store).
+//
+// Columnar file layout (little-endian, native sizes):
+//   "DPBOCOL1", uint32 columnCount, per column: uint32 nameLength, name, uint8 type
+//   blocks of up to BLOCK_ROWS rows: uint32 rowCount, then per column
+//     INT64/DOUBLE: min, max, rowCount values
+//     STRING: uint32 length + bytes of the min and max value, uint32 offsets[rowCount + 1],
+//             then the concatenated bytes
+//   a final uint32 0 marks the end of the file
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bank_customer.h"
+#include "bank_transaction.h"
+#include "hyperloglog.h"
+#include "id_sequence.h"
+#include "item.h"
+#include "order.h"
+#include "tiered_log.h"
+#include "transaction.h"
+
+namespace {
+
+const size_t IO_BUFFER_SIZE = 1 << 20;
+const uint32_t BLOCK_ROWS = 65536;
+
+enum class ColumnType : uint8_t { INT64, DOUBLE, STRING };
+
+struct Column {
+    std::string name;
+    ColumnType type;
+};
+
+struct ExportOptions {
+    bool csv = true;
+    bool columnar = false;
+    int64_t from = std::numeric_limits<int64_t>::min();
+    int64_t to = std::numeric_limits<int64_t>::max();
+    std::string account;
+
+    bool inTimeRange(int64_t seconds) const { return seconds >= from && seconds <= to; }
+};
+
+int64_t epochSeconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+const char* statusName(TransactionStatus status) {
+    switch (status) {
+        case TransactionStatus::PENDING:
+            return "PENDING";
+        case TransactionStatus::PAID:
+            return "PAID";
+        case TransactionStatus::COMPLETED:
+            return "COMPLETED";
+        case TransactionStatus::CANCELED:
+            return "CANCELED";
+    }
+    return "UNKNOWN";
+}
+
+// Receives one row at a time, field by field in column order
+class RowSink {
+   public:
+    virtual ~RowSink() = default;
+    virtual void addInt(int64_t value) = 0;
+    virtual void addDouble(double value) = 0;
+    virtual void addString(const std::string& value) = 0;
+    virtual void endRow() = 0;
+    virtual void finish() = 0;
+};
+
+class CsvSink : public RowSink {
+   private:
+    std::vector<char> buffer;
+    std::ofstream out;
+    bool firstField = true;
+
+    void separate() {
+        if (!firstField) out.put(',');
+        firstField = false;
+    }
+
+   public:
+    CsvSink(const std::string& fileName, const std::vector<Column>& columns)
+        : buffer(IO_BUFFER_SIZE) {
+        out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        out.open(fileName);
+        for (const auto& column : columns) addString(column.name);
+        endRow();
+    }
+
+    void addInt(int64_t value) override {
+        separate();
+        out << value;
+    }
+
+    void addDouble(double value) override {
+        separate();
+        out << value;
+    }
+
+    void addString(const std::string& value) override {
+        separate();
+        if (value.find_first_of(",\"\r\n") == std::string::npos) {
+            out << value;
+            return;
+        }
+        out.put('"');
+        for (char c : value) {
+            if (c == '"') out.put('"');
+            out.put(c);
+        }
+        out.put('"');
+    }
+
+    void endRow() override {
+        out.put('\n');
+        firstField = true;
+    }
+
+    void finish() override { out.close(); }
+};
+
+class ColumnarSink : public RowSink {
+   private:
+    struct ColumnBuffer {
+        ColumnType type;
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        std::vector<std::string> strings;
+    };
+
+    std::vector<char> buffer;
+    std::ofstream out;
+    std::vector<ColumnBuffer> columns;
+    size_t nextColumn = 0;
+    uint32_t rows = 0;
+
+    template <typename T>
+    void write(const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        out.write(value.data(), value.size());
+    }
+
+    template <typename T>
+    void writeNumbers(std::vector<T>& values) {
+        auto bounds = std::minmax_element(values.begin(), values.end());
+        write(*bounds.first);
+        write(*bounds.second);
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        values.clear();
+    }
+
+    void writeStrings(std::vector<std::string>& values) {
+        auto bounds = std::minmax_element(values.begin(), values.end());
+        writeString(*bounds.first);
+        writeString(*bounds.second);
+        uint32_t offset = 0;
+        write(offset);
+        for (const auto& value : values) {
+            offset += static_cast<uint32_t>(value.size());
+            write(offset);
+        }
+        for (const auto& value : values) out.write(value.data(), value.size());
+        values.clear();
+    }
+
+    void flushBlock() {
+        if (rows == 0) return;
+        write(rows);
+        for (auto& column : columns) {
+            switch (column.type) {
+                case ColumnType::INT64:
+                    writeNumbers(column.ints);
+                    break;
+                case ColumnType::DOUBLE:
+                    writeNumbers(column.doubles);
+                    break;
+                case ColumnType::STRING:
+                    writeStrings(column.strings);
+                    break;
+            }
+        }
+        rows = 0;
+    }
+
+   public:
+    ColumnarSink(const std::string& fileName, const std::vector<Column>& schema)
+        : buffer(IO_BUFFER_SIZE) {
+        out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        out.open(fileName, std::ios::binary);
+        out.write("DPBOCOL1", 8);
+        write(static_cast<uint32_t>(schema.size()));
+        for (const auto& column : schema) {
+            writeString(column.name);
+            write(static_cast<uint8_t>(column.type));
+            columns.push_back({column.type, {}, {}, {}});
+        }
+    }
+
+    void addInt(int64_t value) override { columns[nextColumn++].ints.push_back(value); }
+    void addDouble(double value) override { columns[nextColumn++].doubles.push_back(value); }
+    void addString(const std::string& value) override {
+        columns[nextColumn++].strings.push_back(value);
+    }
+
+    void endRow() override {
+        nextColumn = 0;
+        if (++rows == BLOCK_ROWS) flushBlock();
+    }
+
+    void finish() override {
+        flushBlock();
+        write(static_cast<uint32_t>(0));
+        out.close();
+    }
+};
+
+// One exported table, fanned out to every requested format
+class Table {
+   private:
+    std::vector<std::unique_ptr<RowSink>> sinks;
+    size_t rowCount = 0;
+
+   public:
+    Table(const std::string& prefix, const std::string& name, const std::vector<Column>& columns,
+          const ExportOptions& options) {
+        if (options.csv) {
+            sinks.push_back(std::make_unique<CsvSink>(prefix + "_" + name + ".csv", columns));
+        }
+        if (options.columnar) {
+            sinks.push_back(std::make_unique<ColumnarSink>(prefix + "_" + name + ".col", columns));
+        }
+    }
+
+    Table& addInt(int64_t value) {
+        for (auto& sink : sinks) sink->addInt(value);
+        return *this;
+    }
+
+    Table& addDouble(double value) {
+        for (auto& sink : sinks) sink->addDouble(value);
+        return *this;
+    }
+
+    Table& addString(const std::string& value) {
+        for (auto& sink : sinks) sink->addString(value);
+        return *this;
+    }
+
+    void endRow() {
+        for (auto& sink : sinks) sink->endRow();
+        rowCount++;
+    }
+
+    size_t finish() {
+        for (auto& sink : sinks) sink->finish();
+        return rowCount;
+    }
+};
+
+// Opens a data file with a large read buffer
+bool openInput(std::ifstream& in, std::vector<char>& buffer, const std::string& fileName) {
+    buffer.resize(IO_BUFFER_SIZE);
+    in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    in.open(fileName, std::ios::binary);
+    return in.is_open();
+}
+
+// Streams the records of the sealed segments that overlap the time range, in log order
+template <typename Log, typename Visit>
+void forEachSealed(const Log& log, const std::string& dataFile, const ExportOptions& options,
+                   Visit visit) {
+    size_t slash = dataFile.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "" : dataFile.substr(0, slash + 1);
+    std::vector<char> buffer;
+    for (const auto& segment : log.getSegments()) {
+        if (epochSeconds(segment.lastTime) < options.from ||
+            epochSeconds(segment.firstTime) > options.to) {
+            continue;
+        }
+        std::ifstream in;
+        if (!openInput(in, buffer, directory + segment.fileName)) {
+            std::cerr << "missing segment " << segment.fileName << "\n";
+            continue;
+        }
+        size_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        typename Log::value_type record;
+        for (size_t i = 0; i < count && in; i++) {
+            Log::codec_type::read(record, in);
+            if (in) visit(record);
+        }
+    }
+}
+
+// Skips a KeyedDistinctCounts block without allocating its registers
+template <typename Key>
+bool skipDistinctCounts(std::ifstream& in) {
+    size_t count = 0;
+    if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+    for (size_t i = 0; i < count && in; i++) {
+        char present = 0;
+        in.ignore(sizeof(Key));
+        in.read(&present, 1);
+        if (present) in.ignore(HyperLogLog::REGISTER_COUNT);
+    }
+    return static_cast<bool>(in);
+}
+
+bool exportBank(const std::string& fileName, const std::string& prefix,
+                const ExportOptions& options) {
+    std::vector<char> buffer;
+    std::ifstream in;
+    if (!openInput(in, buffer, fileName)) return false;
+
+    // Bank info
+    int bankId, nameLength;
+    in.read(reinterpret_cast<char*>(&bankId), sizeof(bankId));
+    in.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
+    in.ignore(nameLength);
+
+    // Customers
+    Table customers(prefix, "customers",
+                    {{"id", ColumnType::INT64},
+                     {"name", ColumnType::STRING},
+                     {"account", ColumnType::STRING},
+                     {"balance", ColumnType::DOUBLE},
+                     {"last_activity", ColumnType::INT64}},
+                    options);
+    size_t customerCount = 0;
+    in.read(reinterpret_cast<char*>(&customerCount), sizeof(customerCount));
+    for (size_t i = 0; i < customerCount && in; i++) {
+        BankCustomer customer;
+        customer.deserialize(in);
+        if (!options.account.empty() && customer.getAccountNumber() != options.account) continue;
+        customers.addInt(customer.getId())
+            .addString(customer.getName())
+            .addString(customer.getAccountNumber())
+            .addDouble(customer.getBalance())
+            .addInt(epochSeconds(customer.getLastActivityTime()))
+            .endRow();
+    }
+
+    // Ledger
+    Table transactions(prefix, "transactions",
+                       {{"id", ColumnType::INT64},
+                        {"from", ColumnType::STRING},
+                        {"to", ColumnType::STRING},
+                        {"amount", ColumnType::DOUBLE},
+                        {"timestamp", ColumnType::INT64},
+                        {"description", ColumnType::STRING}},
+                       options);
+    auto addTransaction = [&transactions, &options](const BankTransaction& transaction) {
+        int64_t timestamp = epochSeconds(transaction.getTimestamp());
+        if (!options.inTimeRange(timestamp)) return;
+        if (!options.account.empty() && transaction.getFromAccount() != options.account &&
+            transaction.getToAccount() != options.account) {
+            return;
+        }
+        transactions.addInt(transaction.getId())
+            .addString(transaction.getFromAccount())
+            .addString(transaction.getToAccount())
+            .addDouble(transaction.getAmount())
+            .addInt(timestamp)
+            .addString(transaction.getDescription())
+            .endRow();
+    };
+    size_t transactionCount = 0;
+    in.read(reinterpret_cast<char*>(&transactionCount), sizeof(transactionCount));
+    BankTransaction transaction;
+    for (size_t i = 0; i < transactionCount && in; i++) {
+        transaction.deserialize(in);
+        addTransaction(transaction);
+    }
+
+    // Id high-water marks, then the sealed ledger segments (both absent in older files)
+    IdSequence ids;
+    TieredLog<BankTransaction> ledger;
+    if (ids.deserialize(in) && ledger.deserializeDirectory(in)) {
+        forEachSealed(ledger, fileName, options, addTransaction);
+    }
+
+    std::cout << "customers " << customers.finish() << " transactions " << transactions.finish()
+              << "\n";
+    return true;
+}
+
+bool exportStore(const std::string& fileName, const std::string& prefix,
+                 const ExportOptions& options) {
+    std::vector<char> buffer;
+    std::ifstream in;
+    if (!openInput(in, buffer, fileName)) return false;
+
+    int userId = 0;
+    bool filterUser = !options.account.empty();
+    if (filterUser) userId = std::stoi(options.account);
+    auto involvesUser = [filterUser, userId](int buyerId, int sellerId) {
+        return !filterUser || buyerId == userId || sellerId == userId;
+    };
+
+    // Items
+    Table items(prefix, "items",
+                {{"id", ColumnType::INT64},
+                 {"name", ColumnType::STRING},
+                 {"price", ColumnType::DOUBLE},
+                 {"stock", ColumnType::INT64},
+                 {"sold", ColumnType::INT64},
+                 {"last_restock", ColumnType::INT64}},
+                options);
+    size_t itemCount = 0;
+    in.read(reinterpret_cast<char*>(&itemCount), sizeof(itemCount));
+    Item item;
+    for (size_t i = 0; i < itemCount && in; i++) {
+        item.deserialize(in);
+        items.addInt(item.getId())
+            .addString(item.getName())
+            .addDouble(item.getPrice())
+            .addInt(item.getStock())
+            .addInt(item.getSoldCount())
+            .addInt(epochSeconds(item.getLastRestockTime()))
+            .endRow();
+    }
+
+    // Single-item transactions
+    Table transactions(prefix, "transactions",
+                       {{"id", ColumnType::INT64},
+                        {"buyer", ColumnType::INT64},
+                        {"seller", ColumnType::INT64},
+                        {"item", ColumnType::INT64},
+                        {"amount", ColumnType::DOUBLE},
+                        {"status", ColumnType::STRING},
+                        {"timestamp", ColumnType::INT64}},
+                       options);
+    auto addTransaction = [&transactions, &options, &involvesUser](const Transaction& t) {
+        int64_t timestamp = epochSeconds(t.getTimestamp());
+        if (!options.inTimeRange(timestamp) || !involvesUser(t.getBuyerId(), t.getSellerId())) {
+            return;
+        }
+        transactions.addInt(t.getId())
+            .addInt(t.getBuyerId())
+            .addInt(t.getSellerId())
+            .addInt(t.getItemId())
+            .addDouble(t.getAmount())
+            .addString(statusName(t.getStatus()))
+            .addInt(timestamp)
+            .endRow();
+    };
+    size_t transactionCount = 0;
+    in.read(reinterpret_cast<char*>(&transactionCount), sizeof(transactionCount));
+    Transaction transaction;
+    for (size_t i = 0; i < transactionCount && in; i++) {
+        transaction.deserialize(in);
+        addTransaction(transaction);
+    }
+
+    // Id high-water marks, then the orders (both absent in older files)
+    Table orderLines(prefix, "order_lines",
+                     {{"order", ColumnType::INT64},
+                      {"transaction", ColumnType::INT64},
+                      {"buyer", ColumnType::INT64},
+                      {"seller", ColumnType::INT64},
+                      {"item", ColumnType::INT64},
+                      {"quantity", ColumnType::INT64},
+                      {"unit_price", ColumnType::DOUBLE},
+                      {"status", ColumnType::STRING},
+                      {"timestamp", ColumnType::INT64}},
+                     options);
+    IdSequence ids;
+    size_t orderCount = 0;
+    if (ids.deserialize(in) &&
+        in.read(reinterpret_cast<char*>(&orderCount), sizeof(orderCount))) {
+        Order order;
+        for (size_t i = 0; i < orderCount && order.deserialize(in); i++) {
+            int64_t timestamp = epochSeconds(order.getTimestamp());
+            if (!options.inTimeRange(timestamp) ||
+                !involvesUser(order.getBuyerId(), order.getSellerId())) {
+                continue;
+            }
+            const std::vector<OrderLine>& lines = order.getLines();
+            for (size_t l = 0; l < lines.size(); l++) {
+                orderLines.addInt(order.getId())
+                    .addInt(order.getFirstTransactionId() + static_cast<int64_t>(l))
+                    .addInt(order.getBuyerId())
+                    .addInt(order.getSellerId())
+                    .addInt(lines[l].itemId)
+                    .addInt(lines[l].quantity)
+                    .addDouble(lines[l].unitPrice)
+                    .addString(statusName(order.getStatus()))
+                    .addInt(timestamp)
+                    .endRow();
+            }
+        }
+
+        // Distinct-buyer counters, then the sealed log segments; order lines in the segments
+        // were exported above with their orders
+        TieredLog<Transaction, SealedTransactionCodec> log;
+        if (skipDistinctCounts<int>(in) && skipDistinctCounts<int>(in) &&
+            skipDistinctCounts<int64_t>(in) && log.deserializeDirectory(in)) {
+            forEachSealed(log, fileName, options, [&addTransaction](const Transaction& t) {
+                if (!t.isOrderLine()) addTransaction(t);
+            });
+        }
+    }
+
+    std::cout << "items " << items.finish() << " transactions " << transactions.finish()
+              << " order_lines " << orderLines.finish() << "\n";
+    return true;
+}
+
+void printUsage() {
+    std::cout << "Usage: exporter bank|store <data file> <output prefix>"
+                 " [--format csv|columnar|both] [--from <epoch seconds>] [--to <epoch seconds>]"
+                 " [--account <account>]\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        printUsage();
+        return 1;
+    }
+    std::string kind = argv[1];
+    std::string fileName = argv[2];
+    std::string prefix = argv[3];
+
+    ExportOptions options;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--format") {
+            options.csv = value == "csv" || value == "both";
+            options.columnar = value == "columnar" || value == "both";
+        } else if (flag == "--from") {
+            options.from = std::stoll(value);
+        } else if (flag == "--to") {
+            options.to = std::stoll(value);
+        } else if (flag == "--account") {
+            options.account = value;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if ((argc - 4) % 2 != 0 || (!options.csv && !options.columnar)) {
+        printUsage();
+        return 1;
+    }
+
+    bool exported = false;
+    if (kind == "bank") {
+        exported = exportBank(fileName, prefix, options);
+    } else if (kind == "store") {
+        exported = exportStore(fileName, prefix, options);
+    } else {
+        printUsage();
+        return 1;
+    }
+    if (!exported) {
+        std::cout << "Cannot open " << fileName << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+// Count-min sketch: depth rows of width counters, one hashed counter per row and key.
+// estimate() never undercounts; with width = ceil(e / epsilon) and depth = ceil(ln(1 / delta))
+// it overcounts by more than epsilon * total with probability at most delta. The defaults
+// (1024 x 4) give epsilon = 0.27% of the counted volume and delta = 1.8%.
+class CountMinSketch {
+   private:
+    size_t width;
+    size_t depth;
+    uint64_t total = 0;
+    std::vector<uint32_t> counters;
+
+    static uint64_t mix(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // Each row rehashes the key hash with its row number
+    size_t cell(size_t row, uint64_t hash) const {
+        uint64_t rowHash = mix(hash + row);
+        return row * width + static_cast<size_t>(rowHash % width);
+    }
+
+   public:
+    explicit CountMinSketch(size_t width = 1024, size_t depth = 4)
+        : width(std::max<size_t>(width, 1)), depth(std::max<size_t>(depth, 1)) {}
+
+    void add(uint64_t key, uint32_t count = 1) {
+        if (counters.empty()) counters.assign(width * depth, 0);
+        uint64_t hash = mix(key);
+        for (size_t row = 0; row < depth; row++) counters[cell(row, hash)] += count;
+        total += count;
+    }
+
+    uint64_t estimate(uint64_t key) const {
+        if (counters.empty()) return 0;
+        uint64_t hash = mix(key);
+        uint64_t best = UINT64_MAX;
+        for (size_t row = 0; row < depth; row++) {
+            best = std::min<uint64_t>(best, counters[cell(row, hash)]);
+        }
+        return best;
+    }
+
+    // Worst-case overcount at the documented confidence: epsilon * total
+    double errorBound() const { return std::exp(1.0) / width * total; }
+
+    uint64_t getTotal() const { return total; }
+
+    void clear() {
+        std::fill(counters.begin(), counters.end(), 0);
+        total = 0;
+    }
+
+    size_t counterBytes() const { return counters.capacity() * sizeof(uint32_t); }
+};
+
+// Space-saving top-k: at most capacity monitored keys. An unmonitored key replaces the
+// key with the smallest count and inherits that count as its error, so counts never
+// undercount and overcount by at most the error. Every key whose true count exceeds
+// total / capacity is monitored.
+class SpaceSaving {
+   public:
+    struct Counter {
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+
+   private:
+    size_t capacity;
+    std::unordered_map<uint64_t, Counter> counters;
+    std::set<std::pair<uint64_t, uint64_t>> byCount;  // (count, key), smallest first
+
+   public:
+    explicit SpaceSaving(size_t capacity = 64) : capacity(std::max<size_t>(capacity, 1)) {}
+
+    void add(uint64_t key, uint64_t count = 1) {
+        auto it = counters.find(key);
+        if (it == counters.end()) {
+            Counter counter;
+            if (counters.size() >= capacity) {
+                auto smallest = byCount.begin();
+                counter.error = smallest->first;
+                counter.count = smallest->first;
+                counters.erase(smallest->second);
+                byCount.erase(smallest);
+            }
+            it = counters.emplace(key, counter).first;
+        } else {
+            byCount.erase({it->second.count, key});
+        }
+        it->second.count += count;
+        byCount.insert({it->second.count, key});
+    }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (const auto& pair : counters) visit(pair.first, pair.second);
+    }
+
+    size_t size() const { return counters.size(); }
+
+    void clear() {
+        counters.clear();
+        byCount.clear();
+    }
+};
+
+struct HeavyHitter {
+    int64_t key;
+    uint64_t count;  // count-min estimate over the window, never below the true count
+};
+
+// Heavy hitters over sliding time windows.
+// Time is cut into epochs of epochLength; the last epochCount epochs each keep a
+// count-min sketch and a space-saving top-k, reused in a ring as time moves on, so memory
+// is bounded by the constructor arguments whatever the number of keys. top(window) takes
+// the candidates monitored by the epochs inside the window and ranks them by their
+// count-min estimates summed over those epochs.
+// Error bounds for a window with total volume N:
+//  - every key with a true count above N / topCapacity in some epoch of the window is a
+//    candidate; in particular any key above N / topCapacity over the window is;
+//  - each reported count overestimates by at most epsilon * N (see CountMinSketch),
+//    with probability at least 1 - delta per epoch;
+//  - windows are rounded up to whole epochs, so the oldest epoch may include up to
+//    epochLength of events from before the window start.
+class HeavyHitters {
+   private:
+    struct Epoch {
+        int64_t index = -1;
+        CountMinSketch counts;
+        SpaceSaving top;
+
+        Epoch(size_t width, size_t depth, size_t topCapacity)
+            : counts(width, depth), top(topCapacity) {}
+    };
+
+    std::chrono::seconds epochLength;
+    std::vector<Epoch> epochs;
+    int64_t newestEpoch = -1;
+
+    int64_t epochOf(std::chrono::system_clock::time_point time) const {
+        return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch())
+                   .count() /
+               epochLength.count();
+    }
+
+    Epoch& slot(int64_t index) {
+        return epochs[static_cast<size_t>(index) % epochs.size()];
+    }
+
+   public:
+    explicit HeavyHitters(std::chrono::seconds epochLength = std::chrono::minutes(10),
+                          size_t epochCount = 144, size_t width = 1024, size_t depth = 4,
+                          size_t topCapacity = 64)
+        : epochLength(std::max(epochLength, std::chrono::seconds(1))) {
+        epochs.reserve(std::max<size_t>(epochCount, 1));
+        for (size_t i = 0; i < std::max<size_t>(epochCount, 1); i++) {
+            epochs.emplace_back(width, depth, topCapacity);
+        }
+    }
+
+    // Counts an event; events older than the retained epochs are ignored
+    void add(int64_t key, std::chrono::system_clock::time_point time, uint32_t count = 1) {
+        int64_t index = epochOf(time);
+        if (index < 0 || index <= newestEpoch - static_cast<int64_t>(epochs.size())) return;
+        Epoch& epoch = slot(index);
+        if (epoch.index != index) {
+            epoch.index = index;
+            epoch.counts.clear();
+            epoch.top.clear();
+        }
+        epoch.counts.add(static_cast<uint64_t>(key), count);
+        epoch.top.add(static_cast<uint64_t>(key), count);
+        newestEpoch = std::max(newestEpoch, index);
+    }
+
+    // The n heaviest keys of the window ending at now, heaviest first
+    std::vector<HeavyHitter> top(std::chrono::system_clock::time_point now,
+                                 std::chrono::seconds window, size_t n) const {
+        int64_t last = epochOf(now);
+        int64_t spanned = (window.count() + epochLength.count() - 1) / epochLength.count();
+        int64_t first = last - std::min<int64_t>(std::max<int64_t>(spanned, 1),
+                                                 static_cast<int64_t>(epochs.size())) + 1;
+
+        std::vector<const Epoch*> inWindow;
+        for (const auto& epoch : epochs) {
+            if (epoch.index >= first && epoch.index <= last) inWindow.push_back(&epoch);
+        }
+
+        std::unordered_set<uint64_t> candidates;
+        for (const Epoch* epoch : inWindow) {
+            epoch->top.forEach([&candidates](uint64_t key, const SpaceSaving::Counter&) {
+                candidates.insert(key);
+            });
+        }
+
+        std::vector<HeavyHitter> hitters;
+        for (uint64_t key : candidates) {
+            uint64_t count = 0;
+            for (const Epoch* epoch : inWindow) count += epoch->counts.estimate(key);
+            hitters.push_back({static_cast<int64_t>(key), count});
+        }
+        size_t count = std::min(n, hitters.size());
+        std::partial_sort(hitters.begin(), hitters.begin() + count, hitters.end(),
+                          [](const HeavyHitter& a, const HeavyHitter& b) {
+                              return a.count != b.count ? a.count > b.count : a.key < b.key;
+                          });
+        hitters.resize(count);
+        return hitters;
+    }
+
+    // Overcount bound (epsilon * N) of counts reported for the same window
+    double errorBound(std::chrono::system_clock::time_point now,
+                      std::chrono::seconds window) const {
+        int64_t last = epochOf(now);
+        int64_t spanned = (window.count() + epochLength.count() - 1) / epochLength.count();
+        int64_t first = last - std::max<int64_t>(spanned, 1) + 1;
+        double bound = 0.0;
+        for (const auto& epoch : epochs) {
+            if (epoch.index >= first && epoch.index <= last) bound += epoch.counts.errorBound();
+        }
+        return bound;
+    }
+
+    std::chrono::seconds getEpochLength() const { return epochLength; }
+    std::chrono::seconds getMaxWindow() const { return epochLength * epochs.size(); }
+
+    void addMemoryUsage(MemoryUsage& usage) const {
+        usage.objects += epochs.size();
+        usage.addVector(epochs);
+        // Each monitored key has a hash node and a set node
+        const size_t perKey = sizeof(std::pair<const uint64_t, SpaceSaving::Counter>) +
+                              MemoryUsage::HASH_NODE_OVERHEAD +
+                              sizeof(std::pair<uint64_t, uint64_t>) +
+                              MemoryUsage::MAP_NODE_OVERHEAD;
+        for (const auto& epoch : epochs) {
+            usage.bytes += epoch.counts.counterBytes() + epoch.top.size() * perKey;
+        }
+    }
+};
+
+#endif
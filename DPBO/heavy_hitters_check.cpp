@@ -0,0 +1,97 @@
+// Standalone accuracy check for HeavyHitters.
+// Feeds Zipf-distributed sales into a HeavyHitters, compares the result with exact counts
+// and fails when a documented bound does not hold:
+//  - no reported count is below the true count or above it by more than errorBound();
+//  - every key whose true count exceeds N / topCapacity over the window is reported.
+// Seeds are fixed, so a failure is reproducible rather than a matter of luck.
+//
+// Build: g++ -std=c++17 -O2 heavy_hitters_check.cpp -o heavy_hitters_check
+// Usage: heavy_hitters_check   (exit status 0 when every scenario is within bounds)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "heavy_hitters.h"
+
+namespace {
+
+const size_t TOP_CAPACITY = 64;  // the HeavyHitters default
+
+struct Scenario {
+    int events;
+    int items;
+    double exponent;  // Zipf skew
+    unsigned seed;
+};
+
+// Runs one scenario and prints its result line; returns whether the bounds held
+bool check(const Scenario& scenario) {
+    std::vector<double> weights(scenario.items);
+    for (int i = 0; i < scenario.items; i++) {
+        weights[i] = 1.0 / std::pow(i + 1, scenario.exponent);
+    }
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+    std::mt19937 random(scenario.seed);
+
+    HeavyHitters hitters;
+    std::unordered_map<int64_t, int64_t> exact;
+    auto now = std::chrono::system_clock::now();
+    auto begin = now - std::chrono::minutes(50);
+    for (int i = 0; i < scenario.events; i++) {
+        int key = pick(random);
+        hitters.add(key, begin + std::chrono::microseconds(3000000000LL * i / scenario.events));
+        exact[key]++;
+    }
+
+    auto window = std::chrono::hours(1);
+    double bound = hitters.errorBound(now, window);
+    auto reported = hitters.top(now, window, std::numeric_limits<size_t>::max());
+
+    int64_t minOvercount = std::numeric_limits<int64_t>::max();
+    int64_t maxOvercount = std::numeric_limits<int64_t>::min();
+    std::unordered_set<int64_t> reportedKeys;
+    for (const auto& hitter : reported) {
+        int64_t overcount = static_cast<int64_t>(hitter.count) - exact[hitter.key];
+        minOvercount = std::min(minOvercount, overcount);
+        maxOvercount = std::max(maxOvercount, overcount);
+        reportedKeys.insert(hitter.key);
+    }
+
+    size_t heavy = 0, missed = 0;
+    double threshold = static_cast<double>(scenario.events) / TOP_CAPACITY;
+    for (const auto& pair : exact) {
+        if (pair.second <= threshold) continue;
+        heavy++;
+        missed += reportedKeys.count(pair.first) == 0;
+    }
+
+    bool ok = !reported.empty() && minOvercount >= 0 && maxOvercount <= bound && missed == 0;
+    std::cout << (ok ? "ok  " : "FAIL") << " events " << scenario.events << " items "
+              << scenario.items << " exponent " << scenario.exponent << " reported "
+              << reported.size() << " overcount " << minOvercount << ".." << maxOvercount
+              << " bound " << bound << " heavy " << heavy << " missed " << missed << "\n";
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    const Scenario scenarios[] = {
+        {200000, 1000, 1.0, 1},
+        {200000, 1000000, 1.0, 2},
+        {500000, 100000, 1.2, 3},
+        {100000, 50, 0.5, 4},
+    };
+    bool ok = true;
+    for (const auto& scenario : scenarios) ok = check(scenario) && ok;
+    return ok ? 0 : 1;
+}
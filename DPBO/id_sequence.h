@@ -0,0 +1,97 @@
+#ifndef ID_SEQUENCE_H
+#define ID_SEQUENCE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+
+enum class SequenceKind { ITEM, TRANSACTION, CUSTOMER, ORDER };
+
+// Monotonic id counters, one per entity kind.
+// Allocation is a single fetch_add, and the high-water mark is persisted with the owning
+// data file so ids are never reused across restarts.
+class IdSequence {
+   private:
+    static constexpr size_t KIND_COUNT = 4;
+    std::array<std::atomic<int>, KIND_COUNT> counters;
+
+    static size_t index(SequenceKind kind) { return static_cast<size_t>(kind); }
+
+   public:
+    IdSequence() {
+        for (auto& counter : counters) counter.store(1);
+    }
+
+    IdSequence(const IdSequence& other) { *this = other; }
+
+    IdSequence& operator=(const IdSequence& other) {
+        for (size_t i = 0; i < KIND_COUNT; i++) {
+            counters[i].store(other.counters[i].load());
+        }
+        return *this;
+    }
+
+    int next(SequenceKind kind) { return counters[index(kind)].fetch_add(1); }
+
+    // Reserves count consecutive ids and returns the first one
+    int reserve(SequenceKind kind, int count) { return counters[index(kind)].fetch_add(count); }
+
+    // Makes sure an id that already exists is never handed out again
+    void observe(SequenceKind kind, int id) {
+        auto& counter = counters[index(kind)];
+        int current = counter.load();
+        while (current <= id && !counter.compare_exchange_weak(current, id + 1)) {
+        }
+    }
+
+    // Next id that would be allocated
+    int highWaterMark(SequenceKind kind) const { return counters[index(kind)].load(); }
+
+    // Serialization
+    void serialize(std::ofstream& out) const {
+        int kindCount = KIND_COUNT;
+        out.write(reinterpret_cast<const char*>(&kindCount), sizeof(kindCount));
+        for (const auto& counter : counters) {
+            int value = counter.load();
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+
+    // Returns false when the stream holds no sequence block (files written before it existed)
+    bool deserialize(std::ifstream& in) {
+        int kindCount;
+        if (!in.read(reinterpret_cast<char*>(&kindCount), sizeof(kindCount))) return false;
+        for (int i = 0; i < kindCount; i++) {
+            int value;
+            if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) return false;
+            if (i < (int)KIND_COUNT) observe(static_cast<SequenceKind>(i), value - 1);
+        }
+        return true;
+    }
+};
+
+// Thread-local view of an IdSequence that reserves ids in blocks, so concurrent writers
+// only touch the shared counter once per block.
+class IdBlock {
+   private:
+    IdSequence* sequence;
+    SequenceKind kind;
+    int blockSize;
+    int nextId;
+    int endId;
+
+   public:
+    IdBlock(IdSequence& sequence, SequenceKind kind, int blockSize = 64)
+        : sequence(&sequence), kind(kind), blockSize(blockSize), nextId(0), endId(0) {}
+
+    int next() {
+        if (nextId == endId) {
+            nextId = sequence->reserve(kind, blockSize);
+            endId = nextId + blockSize;
+        }
+        return nextId++;
+    }
+};
+
+#endif
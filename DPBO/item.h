@@ -1,91 +1,166 @@
 #ifndef ITEM_H
 #define ITEM_H
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <string>
 
+#include "memory_usage.h"
+#include "serialization.h"
+
+// Stock and soldCount share one 64-bit atomic word (stock in the high half, soldCount in
+// the low half), so a purchase moves units between them in a single compare-and-swap:
+// concurrent buyers can never oversell, and stock + soldCount stays consistent.
 class Item {
    private:
     int id;
     std::string name;
     double price;
-    int stock;
-    int soldCount;
-    std::chrono::system_clock::time_point lastRestockTime;
+    std::atomic<uint64_t> inventory;
+    std::atomic<std::chrono::system_clock::rep> lastRestockTime;
 
-   public:
-    Item() : id(0), name(""), price(0.0), stock(0), soldCount(0) {
-        lastRestockTime = std::chrono::system_clock::now();
+    static uint64_t pack(int stock, int soldCount) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(stock)) << 32) |
+               static_cast<uint32_t>(soldCount);
+    }
+    static int stockOf(uint64_t word) { return static_cast<int32_t>(word >> 32); }
+    static int soldCountOf(uint64_t word) { return static_cast<int32_t>(word & 0xFFFFFFFFu); }
+
+    static std::chrono::system_clock::rep ticksOf(std::chrono::system_clock::time_point time) {
+        return time.time_since_epoch().count();
     }
 
-    Item(int id, std::string name, double price, int stock)
-        : id(id), name(name), price(price), stock(stock), soldCount(0) {
-        lastRestockTime = std::chrono::system_clock::now();
+    friend struct SerializationAccess;
+
+    // Record layout: id, name, price, stock, soldCount, lastRestockTime
+    static constexpr auto serializationFields() {
+        using Rep = std::chrono::system_clock::rep;
+        return std::make_tuple(
+            serialization::raw(&Item::id), serialization::string(&Item::name),
+            serialization::raw(&Item::price),
+            serialization::property<Item, int>(
+                [](const Item& item) { return item.getStock(); },
+                [](Item& item, int stock) {
+                    item.inventory.store(pack(stock, soldCountOf(item.inventory.load())));
+                }),
+            serialization::property<Item, int>(
+                [](const Item& item) { return item.getSoldCount(); },
+                [](Item& item, int soldCount) {
+                    item.inventory.store(pack(stockOf(item.inventory.load()), soldCount));
+                }),
+            serialization::property<Item, Rep>(
+                [](const Item& item) { return item.lastRestockTime.load(); },
+                [](Item& item, Rep ticks) { item.lastRestockTime.store(ticks); }));
+    }
+
+   public:
+    Item()
+        : id(0),
+          name(""),
+          price(0.0),
+          inventory(pack(0, 0)),
+          lastRestockTime(ticksOf(std::chrono::system_clock::now())) {}
+
+    // created stamps the initial stock; pass the owning store's clock time
+    Item(int id, std::string name, double price, int stock,
+         std::chrono::system_clock::time_point created = std::chrono::system_clock::now())
+        : id(id),
+          name(name),
+          price(price),
+          inventory(pack(stock, 0)),
+          lastRestockTime(ticksOf(created)) {}
+
+    Item(const Item& other)
+        : id(other.id),
+          name(other.name),
+          price(other.price),
+          inventory(other.inventory.load()),
+          lastRestockTime(other.lastRestockTime.load()) {}
+
+    Item& operator=(const Item& other) {
+        if (this != &other) {
+            id = other.id;
+            name = other.name;
+            price = other.price;
+            inventory.store(other.inventory.load());
+            lastRestockTime.store(other.lastRestockTime.load());
+        }
+        return *this;
     }
 
     // Getters
     int getId() const { return id; }
     std::string getName() const { return name; }
     double getPrice() const { return price; }
-    int getStock() const { return stock; }
-    int getSoldCount() const { return soldCount; }
-    std::chrono::system_clock::time_point getLastRestockTime() const { return lastRestockTime; }
+    int getStock() const { return stockOf(inventory.load()); }
+    int getSoldCount() const { return soldCountOf(inventory.load()); }
+    std::chrono::system_clock::time_point getLastRestockTime() const {
+        return std::chrono::system_clock::time_point(
+            std::chrono::system_clock::duration(lastRestockTime.load()));
+    }
 
     // Setters
     void setId(int id) { this->id = id; }
     void setName(std::string name) { this->name = name; }
     void setPrice(double price) { this->price = price; }
-    void setStock(int stock) {
-        this->stock = stock;
-        this->lastRestockTime = std::chrono::system_clock::now();
+    void setStock(int stock,
+                  std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+        uint64_t current = inventory.load();
+        while (!inventory.compare_exchange_weak(current, pack(stock, soldCountOf(current)))) {
+        }
+        lastRestockTime.store(ticksOf(now));
     }
 
     // Business logic
+
+    // Reserves amount units with a CAS loop; fails without side effects when stock runs out
     bool decreaseStock(int amount) {
-        if (stock >= amount) {
-            stock -= amount;
-            soldCount += amount;
-            return true;
-        }
-        return false;
+        uint64_t current = inventory.load();
+        do {
+            if (stockOf(current) < amount) return false;
+        } while (!inventory.compare_exchange_weak(
+            current, pack(stockOf(current) - amount, soldCountOf(current) + amount)));
+        return true;
     }
 
-    void increaseStock(int amount) {
-        stock += amount;
-        lastRestockTime = std::chrono::system_clock::now();
+    // Reserves up to amount units and returns how many were taken
+    int reserveUpTo(int amount) {
+        uint64_t current = inventory.load();
+        int taken;
+        do {
+            taken = std::min(amount, stockOf(current));
+            if (taken <= 0) return 0;
+        } while (!inventory.compare_exchange_weak(
+            current, pack(stockOf(current) - taken, soldCountOf(current) + taken)));
+        return taken;
     }
 
-    // Serialization
-    void serialize(std::ofstream& out) const {
-        int nameLength = name.length();
-        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
-        out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
-        out.write(name.c_str(), nameLength);
-        out.write(reinterpret_cast<const char*>(&price), sizeof(price));
-        out.write(reinterpret_cast<const char*>(&stock), sizeof(stock));
-        out.write(reinterpret_cast<const char*>(&soldCount), sizeof(soldCount));
-        auto time = lastRestockTime.time_since_epoch().count();
-        out.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    // Undoes a decreaseStock whose sale did not go through
+    void cancelSale(int amount) {
+        uint64_t current = inventory.load();
+        while (!inventory.compare_exchange_weak(
+            current, pack(stockOf(current) + amount, soldCountOf(current) - amount))) {
+        }
     }
 
-    void deserialize(std::ifstream& in) {
-        int nameLength;
-        in.read(reinterpret_cast<char*>(&id), sizeof(id));
-        in.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
-        char* nameBuffer = new char[nameLength + 1];
-        in.read(nameBuffer, nameLength);
-        nameBuffer[nameLength] = '\0';
-        name = std::string(nameBuffer);
-        delete[] nameBuffer;
-        in.read(reinterpret_cast<char*>(&price), sizeof(price));
-        in.read(reinterpret_cast<char*>(&stock), sizeof(stock));
-        in.read(reinterpret_cast<char*>(&soldCount), sizeof(soldCount));
-        typename std::chrono::system_clock::duration::rep time;
-        in.read(reinterpret_cast<char*>(&time), sizeof(time));
-        lastRestockTime =
-            std::chrono::system_clock::time_point(std::chrono::system_clock::duration(time));
+    void increaseStock(
+        int amount, std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+        uint64_t current = inventory.load();
+        while (!inventory.compare_exchange_weak(
+            current, pack(stockOf(current) + amount, soldCountOf(current)))) {
+        }
+        lastRestockTime.store(ticksOf(now));
     }
+
+    // Heap memory owned by this item beyond sizeof(Item)
+    void addHeapUsage(MemoryUsage& usage) const { usage.addString(name); }
+
+    // Serialization
+    void serialize(std::ofstream& out) const { serialization::write(*this, out); }
+    void deserialize(std::ifstream& in) { serialization::read(*this, in); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+// Standalone check that seller loyalty stats follow transaction status changes made
+// through the Store. Runs purchases, checkout-style commits and an order against an
+// in-memory Store, moves them between statuses with Store::updateTransactionStatus and
+// Store::updateOrderStatus, and fails when Seller::getLoyalCustomers or the buyer's status
+// lists disagree with the expected result.
+//
+// Build: g++ -std=c++17 -O2 loyalty_check.cpp -o loyalty_check
+// Usage: loyalty_check   (exit status 0 when every step matches)
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "store.h"
+
+namespace {
+
+bool failed = false;
+
+void expect(bool condition, const std::string& step) {
+    std::cout << (condition ? "ok   " : "FAIL ") << step << "\n";
+    if (!condition) failed = true;
+}
+
+bool sameIds(const std::vector<int>& actual, const std::vector<int>& expected) {
+    return actual == expected;
+}
+
+}  // namespace
+
+int main() {
+    Store store("");
+    const int sellerId = 100;
+    store.addSeller(Seller(sellerId, "Shop"));
+    for (int buyerId = 1; buyerId <= 3; buyerId++) {
+        store.addBuyer(Buyer(buyerId, "Buyer " + std::to_string(buyerId)));
+    }
+    store.addItem(Item(1, "Widget", 10.0, 100));
+    store.addItem(Item(2, "Gadget", 25.0, 100));
+
+    // Buyer 1: two purchases; buyer 2: one purchase
+    std::vector<int> purchases;
+    for (int buyerId : {1, 1, 2}) {
+        Transaction transaction(store.nextTransactionId(), buyerId, sellerId, 1, 10.0);
+        if (store.processTransaction(transaction)) purchases.push_back(transaction.getId());
+    }
+    expect(purchases.size() == 3, "purchases recorded");
+    expect(store.findSeller(sellerId)->getLoyalCustomers().empty(),
+           "no loyal customers before completion");
+
+    for (int id : purchases) store.updateTransactionStatus(id, TransactionStatus::COMPLETED);
+    expect(sameIds(store.findSeller(sellerId)->getLoyalCustomers(), {1, 2}),
+           "completed purchases rank buyer 1 before buyer 2");
+    expect(store.findBuyer(1)->getTransactions(TransactionStatus::COMPLETED).size() == 2 &&
+               store.findBuyer(1)->getTransactions(TransactionStatus::PENDING).empty(),
+           "buyer status lists follow the store");
+
+    // A checkout-style commit (already paid, handed to buyer and seller by the caller)
+    Transaction checkout(store.nextTransactionId(), 3, sellerId, 2, 75.0);
+    checkout.setQuantity(3);
+    checkout.setStatus(TransactionStatus::PAID);
+    store.reserveStock(2, 3);
+    store.commitTransaction(checkout);
+    store.findBuyer(3)->addTransaction(checkout);
+    store.findSeller(sellerId)->addTransaction(checkout);
+    store.updateTransactionStatus(checkout.getId(), TransactionStatus::COMPLETED);
+    expect(sameIds(store.findSeller(sellerId)->getLoyalCustomers(), {1, 3, 2}),
+           "completed checkout counts, ranked by amount among single purchases");
+
+    // Canceling a completed purchase takes it back out of the stats
+    store.updateTransactionStatus(purchases[0], TransactionStatus::CANCELED);
+    expect(sameIds(store.findSeller(sellerId)->getLoyalCustomers(), {3, 1, 2}),
+           "canceled purchase no longer counts");
+
+    // An order of two lines for buyer 2, completed as a whole
+    Order order(store.nextOrderId(), 2, sellerId);
+    order.addLine(1, 1);
+    order.addLine(2, 1);
+    store.processOrder(order);
+    store.updateOrderStatus(order.getId(), TransactionStatus::COMPLETED);
+    expect(sameIds(store.findSeller(sellerId)->getLoyalCustomers(1), {2}),
+           "completed order lines make buyer 2 the most loyal");
+
+    return failed ? 1 : 0;
+}
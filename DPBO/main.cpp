@@ -1,11 +1,21 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "bank.h"
+#include "benchmarks.h"
 #include "buyer.h"
+#include "checkout_pipeline.h"
+#include "clock.h"
 #include "item.h"
 #include "seller.h"
 #include "store.h"
@@ -39,6 +49,48 @@ class ECommerceSystem {
     Bank bank;
     Store store;
     User* currentUser;
+    SimulatedClock simulatedClock;
+
+    // Batch-mode checkouts in flight, with the latency of the ones already finished
+    std::unique_ptr<CheckoutPipeline> checkoutPipeline;
+    std::vector<std::future<CheckoutResult>> pendingCheckouts;
+    std::vector<double> checkoutLatencies;
+    int failedCheckouts = 0;
+    double checkoutSeconds = 0.0;
+    std::chrono::steady_clock::time_point checkoutStart;
+
+    // Waits for the queued checkouts and stops the pipeline, so other commands see a
+    // quiescent store
+    void finishCheckouts(std::ostream& out) {
+        if (!checkoutPipeline) return;
+        for (auto& pending : pendingCheckouts) {
+            CheckoutResult result = pending.get();
+            checkoutLatencies.push_back(result.latencyMicros);
+            if (result.success) {
+                out << "checkout " << result.transactionId << "\n";
+            } else {
+                failedCheckouts++;
+                out << "checkout failed " << result.reason << "\n";
+            }
+        }
+        checkoutPipeline.reset();
+        pendingCheckouts.clear();
+        auto finished = std::chrono::steady_clock::now();
+        checkoutSeconds += std::chrono::duration<double>(finished - checkoutStart).count();
+    }
+
+    std::string memoryReport() const {
+        MemoryReport report;
+        bank.addMemoryUsage(report);
+        store.addMemoryUsage(report);
+        return report.format();
+    }
+
+    void showMemoryUsage() {
+        displayHeader("Memory Usage");
+        std::cout << memoryReport();
+        pauseScreen();
+    }
 
     void showBankMenu() {
         int choice;
@@ -55,9 +107,8 @@ class ECommerceSystem {
 
             switch (choice) {
                 case 1: {
-                    auto transactions = bank.getRecentTransactions(7);
                     displayHeader("Recent Transactions");
-                    for (const auto& trans : transactions) {
+                    for (const auto& trans : bank.recentTransactionsView(7)) {
                         std::cout << "From: " << trans.getFromAccount()
                                   << " To: " << trans.getToAccount() << " Amount: $"
                                   << trans.getAmount() << "\n";
@@ -65,9 +116,8 @@ class ECommerceSystem {
                     break;
                 }
                 case 2: {
-                    auto dormant = bank.getDormantAccounts();
                     displayHeader("Dormant Accounts");
-                    for (const auto& acc : dormant) {
+                    for (const auto& acc : bank.dormantAccountsView()) {
                         std::cout << "Account: " << acc.getAccountNumber()
                                   << " Name: " << acc.getName() << "\n";
                     }
@@ -95,7 +145,8 @@ class ECommerceSystem {
                     std::cout << "Enter account number: ";
                     std::cin >> accountNum;
 
-                    BankCustomer newCustomer(bank.getId(), name, accountNum);
+                    BankCustomer newCustomer(bank.nextCustomerId(), name, accountNum,
+                                             bank.getClock().now());
                     if (bank.addCustomer(newCustomer)) {
                         std::cout << "Customer added successfully!\n";
                     } else {
@@ -126,9 +177,8 @@ class ECommerceSystem {
                     int days;
                     std::cout << "Enter number of days: ";
                     std::cin >> days;
-                    auto transactions = store.getTransactionsInLastDays(days);
                     displayHeader("Recent Store Transactions");
-                    for (const auto& trans : transactions) {
+                    for (const auto& trans : store.getTransactionsInLastDays(days)) {
                         std::cout << "Buyer: " << trans.getBuyerId()
                                   << " Item: " << trans.getItemId() << " Amount: $"
                                   << trans.getAmount() << "\n";
@@ -136,9 +186,8 @@ class ECommerceSystem {
                     break;
                 }
                 case 2: {
-                    auto pending = store.getPendingTransactions();
                     displayHeader("Pending Transactions");
-                    for (const auto& trans : pending) {
+                    for (const auto& trans : store.getPendingTransactions()) {
                         std::cout << "Transaction ID: " << trans.getId() << " Amount: $"
                                   << trans.getAmount() << "\n";
                     }
@@ -173,7 +222,7 @@ class ECommerceSystem {
                     std::cout << "Enter initial stock: ";
                     std::cin >> stock;
 
-                    Item newItem(store.getMostSoldItems(1).size() + 1, name, price, stock);
+                    Item newItem(store.nextItemId(), name, price, stock, store.getClock().now());
                     if (store.addItem(newItem)) {
                         std::cout << "Item added successfully!\n";
                     } else {
@@ -186,13 +235,395 @@ class ECommerceSystem {
         } while (choice != 0);
     }
 
-   public:
-    ECommerceSystem() : currentUser(nullptr) {
-        // Initialize with some data
-        bank = Bank(1, "E-Commerce Bank", "Digital Street 123", "123-456-789");
-        store = Store();
+    // Reads the rest of a command line, without the separating space
+    static std::string readRest(std::istringstream& args) {
+        std::string rest;
+        std::getline(args >> std::ws, rest);
+        return rest;
+    }
+
+    // Executes one batch command and writes a compact result line to out
+    bool executeCommand(const std::string& command, std::istringstream& args, std::ostream& out) {
+        if (command == "checkout") {
+            CheckoutRequest request{0, 0, 0, 1};
+            if (!(args >> request.buyerId >> request.sellerId >> request.itemId)) return false;
+            args >> request.quantity;
+            if (!checkoutPipeline) {
+                checkoutPipeline = std::make_unique<CheckoutPipeline>(store, bank);
+                checkoutStart = std::chrono::steady_clock::now();
+            }
+            pendingCheckouts.push_back(checkoutPipeline->submit(request));
+            return true;
+        }
+        finishCheckouts(out);
+
+        if (command == "buyer") {
+            int buyerId = 0;
+            std::string accountNum;
+            if (!(args >> buyerId >> accountNum)) return false;
+            BankCustomer* account = bank.findCustomer(accountNum);
+            if (!account || !store.addBuyer(Buyer(buyerId, readRest(args)))) return false;
+            store.findBuyer(buyerId)->createBankAccount(account);
+            out << "buyer " << buyerId << "\n";
+            return true;
+        }
+        if (command == "seller") {
+            int sellerId = 0;
+            std::string accountNum;
+            if (!(args >> sellerId >> accountNum)) return false;
+            BankCustomer* account = bank.findCustomer(accountNum);
+            if (!account || !store.addSeller(Seller(sellerId, readRest(args)))) return false;
+            store.findSeller(sellerId)->createBankAccount(account);
+            out << "seller " << sellerId << "\n";
+            return true;
+        }
+        if (command == "customer") {
+            std::string accountNum;
+            args >> accountNum;
+            std::string name = readRest(args);
+            if (accountNum.empty() || name.empty()) return false;
+            int customerId = bank.nextCustomerId();
+            BankCustomer customer(customerId, name, accountNum, bank.getClock().now());
+            if (!bank.addCustomer(customer)) return false;
+            out << "customer " << customerId << " " << accountNum << "\n";
+            return true;
+        }
+        if (command == "deposit") {
+            std::string accountNum;
+            double amount = 0.0;
+            if (!(args >> accountNum >> amount)) return false;
+            BankCustomer* customer = bank.findCustomer(accountNum);
+            if (!customer || amount <= 0) return false;
+            customer->deposit(amount, bank.getClock().now());
+            out << "deposit " << accountNum << " " << customer->getBalance() << "\n";
+            return true;
+        }
+        if (command == "transfer") {
+            std::string from, to;
+            double amount = 0.0;
+            if (!(args >> from >> to >> amount)) return false;
+            BankTransaction transaction(bank.nextTransactionId(), from, to, amount,
+                                        readRest(args), bank.getClock().now());
+            if (!bank.processTransaction(transaction)) return false;
+            out << "transfer " << transaction.getId() << "\n";
+            return true;
+        }
+        if (command == "limit") {
+            int tier = 0, maxTransfers = 0;
+            double maxAmount = 0.0;
+            if (!(args >> tier >> maxTransfers >> maxAmount) || tier < 0) return false;
+            bank.setVelocityLimits(tier, {maxTransfers, maxAmount});
+            out << "limit " << tier << " " << maxTransfers << " " << maxAmount << "\n";
+            return true;
+        }
+        if (command == "tier") {
+            std::string accountNum;
+            int tier = 0;
+            if (!(args >> accountNum >> tier) || !bank.setAccountTier(accountNum, tier)) {
+                return false;
+            }
+            out << "tier " << accountNum << " " << tier << "\n";
+            return true;
+        }
+        if (command == "item") {
+            double price = 0.0;
+            int stock = 0;
+            if (!(args >> price >> stock)) return false;
+            std::string name = readRest(args);
+            if (name.empty()) return false;
+            Item newItem(store.nextItemId(), name, price, stock, store.getClock().now());
+            if (!store.addItem(newItem)) return false;
+            out << "item " << newItem.getId() << "\n";
+            return true;
+        }
+        if (command == "purchase") {
+            int buyerId = 0, sellerId = 0, itemId = 0;
+            if (!(args >> buyerId >> sellerId >> itemId)) return false;
+            Item* item = store.findItem(itemId);
+            if (!item) return false;
+            Transaction transaction(store.nextTransactionId(), buyerId, sellerId, itemId,
+                                    item->getPrice(), store.getClock().now());
+            if (!store.processTransaction(transaction)) return false;
+            out << "purchase " << transaction.getId() << "\n";
+            return true;
+        }
+        if (command == "order") {
+            int buyerId = 0, sellerId = 0;
+            if (!(args >> buyerId >> sellerId)) return false;
+            Order order(store.nextOrderId(), buyerId, sellerId, store.getClock().now());
+            std::string line;
+            while (args >> line) {
+                int itemId = 0, quantity = 1;
+                char separator = 0;
+                std::istringstream lineArgs(line);
+                if (!(lineArgs >> itemId)) return false;
+                if (lineArgs >> separator && (separator != ':' || !(lineArgs >> quantity))) {
+                    return false;
+                }
+                if (!order.addLine(itemId, quantity)) return false;
+            }
+            if (!store.processOrder(order)) return false;
+            out << "order " << order.getId() << " lines " << order.getLines().size()
+                << " units " << order.getUnitCount() << " total " << order.getTotal() << "\n";
+            return true;
+        }
+        if (command == "status") {
+            std::string target, name;
+            int id = 0;
+            if (!(args >> target >> id >> name)) return false;
+            const std::map<std::string, TransactionStatus> statuses = {
+                {"pending", TransactionStatus::PENDING},
+                {"paid", TransactionStatus::PAID},
+                {"completed", TransactionStatus::COMPLETED},
+                {"canceled", TransactionStatus::CANCELED}};
+            auto status = statuses.find(name);
+            if (status == statuses.end()) return false;
+            bool updated = target == "transaction"
+                               ? store.updateTransactionStatus(id, status->second)
+                           : target == "order" ? store.updateOrderStatus(id, status->second)
+                                               : false;
+            if (!updated) return false;
+            out << "status " << target << " " << id << " " << name << "\n";
+            return true;
+        }
+        if (command == "price") {
+            int itemId = 0;
+            double price = 0.0;
+            if (!(args >> itemId >> price) || !store.setItemPrice(itemId, price)) return false;
+            out << "price " << itemId << " " << price << "\n";
+            return true;
+        }
+        if (command == "restock") {
+            int itemId = 0, quantity = 0;
+            if (!(args >> itemId >> quantity) || !store.restockItem(itemId, quantity)) return false;
+            out << "restock " << itemId << " " << store.findItem(itemId)->getStock() << "\n";
+            return true;
+        }
+        if (command == "browse") {
+            double minPrice = 0.0, maxPrice = 0.0;
+            std::string filter;
+            size_t pageSize = 10;
+            if (!(args >> minPrice >> maxPrice >> filter)) return false;
+            args >> pageSize;
+            if (pageSize == 0 || (filter != "all" && filter != "instock")) return false;
+
+            PriceCursor cursor;
+            std::vector<const Item*> page;
+            int pageNumber = 1;
+            while (!(page = store.browseByPrice(minPrice, maxPrice, filter == "instock",
+                                                pageSize, cursor))
+                        .empty()) {
+                out << "page " << pageNumber++;
+                for (const Item* item : page) out << " " << item->getId();
+                out << "\n";
+            }
+            return true;
+        }
+        if (command == "rename") {
+            int itemId = 0;
+            if (!(args >> itemId)) return false;
+            if (!store.renameItem(itemId, readRest(args))) return false;
+            out << "rename " << itemId << "\n";
+            return true;
+        }
+        if (command == "search") {
+            std::string mode;
+            if (!(args >> mode)) return false;
+            std::string text = readRest(args);
+            std::vector<const Item*> found;
+            if (mode == "prefix") {
+                found = store.autocompleteItems(text);
+            } else if (mode == "fuzzy") {
+                found = store.fuzzySearchItems(text);
+            } else if (mode == "substring") {
+                found = store.searchItems(text);
+            } else {
+                return false;
+            }
+            out << "search " << found.size();
+            for (const Item* item : found) out << " " << item->getId();
+            out << "\n";
+            return true;
+        }
+        if (command == "clock") {
+            std::string action;
+            args >> action;
+            if (action == "simulate") {
+                bank.setClock(simulatedClock);
+                store.setClock(simulatedClock);
+                out << "clock simulated\n";
+                return true;
+            }
+            double hours = 0.0;
+            if (action == "advance" && args >> hours) {
+                std::chrono::duration<double, std::ratio<3600>> step(hours);
+                simulatedClock.advance(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(step));
+                out << "clock advanced " << hours << "h\n";
+                return true;
+            }
+            return false;
+        }
+        if (command == "bench") {
+            std::string name;
+            args >> name;
+            if (name == "stock") {
+                int threads = 64, stock = 1000000, leaseChunk = 0;
+                args >> threads >> stock >> leaseChunk;
+                if (threads <= 0 || stock < 0) return false;
+                out << benchStockContention(threads, stock, leaseChunk);
+                return true;
+            }
+            if (name == "lookup") {
+                int accounts = 10000000, lookups = 1000000;
+                args >> accounts >> lookups;
+                if (accounts <= 0 || lookups < 0) return false;
+                out << benchCustomerLookup(accounts, lookups);
+                return true;
+            }
+            if (name == "velocity") {
+                int accounts = 100000, checks = 1000000;
+                args >> accounts >> checks;
+                if (accounts <= 0 || checks < 0) return false;
+                out << benchVelocityChecks(accounts, checks);
+                return true;
+            }
+            if (name == "trending") {
+                int events = 1000000, itemCount = 1000000;
+                args >> events >> itemCount;
+                if (events < 0 || itemCount <= 0) return false;
+                out << benchTrending(events, itemCount);
+                return true;
+            }
+            if (name == "checkout") {
+                int checkouts = 100000, buyerCount = 1000, batch = 256;
+                args >> checkouts >> buyerCount >> batch;
+                if (checkouts < 0 || buyerCount <= 0 || batch <= 0) return false;
+                out << benchCheckout(checkouts, buyerCount, batch);
+                return true;
+            }
+            if (name == "quantiles") {
+                int values = 1000000, threads = 4;
+                args >> values >> threads;
+                if (values <= 0 || threads <= 0) return false;
+                out << benchQuantiles(values, threads);
+                return true;
+            }
+            if (name == "search") {
+                int itemCount = 100000, queries = 1000;
+                args >> itemCount >> queries;
+                if (itemCount <= 0 || queries < 0) return false;
+                out << benchCatalogSearch(itemCount, queries);
+                return true;
+            }
+            if (name == "shards") {
+                size_t shardCount = 0;
+                int accounts = 0, transfers = 0;
+                if (!(args >> shardCount >> accounts >> transfers) || accounts <= 0) return false;
+                out << benchShardedTransfers(shardCount, accounts, transfers);
+                return true;
+            }
+            return false;
+        }
+        if (command == "history") {
+            std::string target;
+            if (!(args >> target)) return false;
+            if (target == "account") {
+                // Loads the customer's history from the history store on first use
+                std::string accountNum;
+                if (!(args >> accountNum)) return false;
+                const BankCustomer* customer = bank.findCustomer(accountNum);
+                if (!customer) return false;
+                out << "history account " << accountNum << " "
+                    << customer->getTransactions().size() << "\n";
+                return true;
+            }
+            int days = 0;
+            if (!(args >> days) || days < 0) return false;
+            size_t count;
+            if (target == "bank") {
+                count = bank.getRecentTransactions(days).size();
+            } else if (target == "store") {
+                count = store.getTransactionsInLastDays(days).size();
+            } else {
+                return false;
+            }
+            out << "history " << target << " " << days << " " << count << "\n";
+            return true;
+        }
+        if (command == "trending") {
+            int minutes = 0, count = 10;
+            if (!(args >> minutes) || minutes <= 0) return false;
+            args >> count;
+            if (count <= 0) return false;
+            std::chrono::seconds window = std::chrono::minutes(minutes);
+            for (const auto& hitter : store.getTrendingItems(window, count)) {
+                out << "trending " << hitter.key << " " << hitter.count << "\n";
+            }
+            out << "error_bound " << store.getTrendingErrorBound(window) << "\n";
+            return true;
+        }
+        if (command == "buyers") {
+            std::string scope;
+            int value = 1;
+            if (!(args >> scope)) return false;
+            if (!(args >> value)) {
+                if (scope != "days") return false;
+                value = 1;
+            }
+            double estimate;
+            if (scope == "seller") {
+                estimate = store.countDistinctBuyersOfSeller(value);
+            } else if (scope == "item") {
+                estimate = store.countDistinctBuyersOfItem(value);
+            } else if (scope == "days" && value > 0) {
+                estimate = store.countDistinctBuyersRecent(value);
+            } else {
+                return false;
+            }
+            out << "buyers " << scope << " " << value << " " << std::llround(estimate) << "\n";
+            return true;
+        }
+        if (command == "memory") {
+            std::string fileName = readRest(args);
+            if (fileName.empty()) {
+                out << memoryReport();
+                return true;
+            }
+            std::ofstream dump(fileName);
+            if (!dump) return false;
+            dump << memoryReport();
+            out << "memory dumped to " << fileName << "\n";
+            return true;
+        }
+        if (command == "report") {
+            std::string target;
+            args >> target;
+            if (target == "bank") {
+                out << bank.generateReport();
+                return true;
+            }
+            if (target == "store") {
+                out << "pending " << store.countTransactionsByStatus(TransactionStatus::PENDING)
+                    << " paid " << store.countTransactionsByStatus(TransactionStatus::PAID)
+                    << "\n";
+                for (const auto& item : store.getMostSoldItems(5)) {
+                    out << "top " << item.getId() << " " << item.getSoldCount() << "\n";
+                }
+                out << store.generateAmountReport();
+                return true;
+            }
+            return false;
+        }
+        return false;
     }
 
+   public:
+    // Bank and store are built in place: a temporary assigned over them would load and
+    // save the same data files a second time
+    ECommerceSystem()
+        : bank(1, "E-Commerce Bank", "Digital Street 123", "123-456-789"), currentUser(nullptr) {}
+
     void run() {
         int choice;
         do {
@@ -200,6 +631,7 @@ class ECommerceSystem {
             std::cout << "1. Bank Management\n";
             std::cout << "2. Store Management\n";
             std::cout << "3. User Management\n";
+            std::cout << "4. Memory Usage\n";
             std::cout << "0. Exit\n\n";
             std::cout << "Choice: ";
             std::cin >> choice;
@@ -214,6 +646,9 @@ class ECommerceSystem {
                 case 3:
                     // User management menu would go here
                     break;
+                case 4:
+                    showMemoryUsage();
+                    break;
                 case 0:
                     std::cout << "\nSaving all data...\n";
                     break;
@@ -223,11 +658,112 @@ class ECommerceSystem {
             }
         } while (choice != 0);
     }
+
+    // Non-interactive mode: one command per line, no screen handling.
+    // Commands: customer <account> <name>, deposit <account> <amount>,
+    // transfer <from> <to> <amount> [description], limit <tier> <maxTransfers> <maxAmount>,
+    // tier <account> <tier>, item <price> <stock> <name>,
+    // purchase <buyerId> <sellerId> <itemId>,
+    // order <buyerId> <sellerId> <itemId>[:quantity]..., price <itemId> <price>,
+    // status transaction|order <id> pending|paid|completed|canceled,
+    // restock <itemId> <quantity>, browse <min> <max> all|instock [pageSize],
+    // rename <itemId> <name>,
+    // search substring|prefix|fuzzy <text>, report bank|store, memory [dump file],
+    // buyers seller <id>|item <id>|days [n=1] (estimated distinct buyers),
+    // trending <minutes> [count=10], history bank|store <days>, history account <account>,
+    // clock simulate (switch queries to a simulated clock), clock advance <hours>,
+    // bench shards <shards> <accounts> <transfers>,
+    // bench stock [threads=64] [stock=1000000] [leaseChunk=0],
+    // bench search [items=100000] [queries=1000],
+    // bench velocity [accounts=100000] [checks=1000000],
+    // bench lookup [accounts=10000000] [lookups=1000000],
+    // bench quantiles [values=1000000] [threads=4],
+    // bench checkout [checkouts=100000] [buyers=1000] [batch=256],
+    // bench trending [events=1000000] [items=1000000], buyer <id> <account> <name>,
+    // seller <id> <account> <name>, checkout <buyerId> <sellerId> <itemId> [quantity].
+    // Consecutive checkouts are queued on the asynchronous CheckoutPipeline and complete
+    // before the next other command runs.
+    // Blank lines and lines starting with '#' are skipped.
+    void runBatch(std::istream& in, std::ostream& out) {
+        // Queries read a cached clock unless the script switches to the simulated one
+        CoarseClock coarseClock;
+        bank.setClock(coarseClock);
+        store.setClock(coarseClock);
+
+        std::vector<double> latencies;
+        int failed = 0;
+        std::string line;
+        std::ostringstream results;
+        auto batchStart = std::chrono::steady_clock::now();
+
+        for (int lineNumber = 1; std::getline(in, line); lineNumber++) {
+            std::istringstream args(line);
+            std::string command;
+            if (!(args >> command) || command[0] == '#') continue;
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = executeCommand(command, args, results);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+            if (!ok) {
+                failed++;
+                results << "fail " << lineNumber << " " << command << "\n";
+            }
+        }
+
+        finishCheckouts(results);
+        double elapsed =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        bank.setClock(SystemClock::instance());
+        store.setClock(SystemClock::instance());
+        out << results.str();
+
+        auto percentile = [&latencies](double p) {
+            if (latencies.empty()) return 0.0;
+            size_t rank = std::min(latencies.size() - 1, (size_t)(p * latencies.size()));
+            std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+            return latencies[rank];
+        };
+
+        out << std::fixed << std::setprecision(2);
+        out << "commands " << latencies.size() << " failed " << failed << " elapsed_ms "
+            << elapsed * 1000.0 << " throughput "
+            << (elapsed > 0 ? latencies.size() / elapsed : 0.0) << "/s\n";
+        out << "latency_us p50 " << percentile(0.50) << " p99 " << percentile(0.99) << " max "
+            << percentile(1.0) << "\n";
+
+        if (!checkoutLatencies.empty()) {
+            size_t checkouts = checkoutLatencies.size();
+            latencies.swap(checkoutLatencies);
+            out << "checkouts " << checkouts << " failed " << failedCheckouts << " throughput "
+                << (checkoutSeconds > 0 ? checkouts / checkoutSeconds : 0.0) << "/s\n";
+            out << "checkout_latency_us p50 " << percentile(0.50) << " p99 " << percentile(0.99)
+                << " max " << percentile(1.0) << "\n";
+            latencies.clear();
+            failedCheckouts = 0;
+            checkoutSeconds = 0.0;
+        }
+    }
 };
 
-int main() {
+// Usage: main [--batch [script]]; without a script, batch commands are read from stdin
+int main(int argc, char* argv[]) {
     try {
         ECommerceSystem system;
+        if (argc > 1 && std::string(argv[1]) == "--batch") {
+            if (argc > 2) {
+                std::ifstream script(argv[2]);
+                if (!script.is_open()) {
+                    std::cerr << "Error: cannot open " << argv[2] << std::endl;
+                    return 1;
+                }
+                system.runBatch(script, std::cout);
+            } else {
+                system.runBatch(std::cin, std::cout);
+            }
+            return 0;
+        }
         system.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
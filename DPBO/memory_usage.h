@@ -0,0 +1,100 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Live bytes and object counts of one subsystem, gathered by walking its containers.
+// Payload sizes come from the containers' capacities; per-node overheads of the standard
+// containers follow the libstdc++ layouts (see the constants below) and are estimates.
+struct MemoryUsage {
+    // Red-black tree node header: color plus parent, left and right links
+    static constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+    // Hash node header: next link plus cached hash
+    static constexpr size_t HASH_NODE_OVERHEAD = 2 * sizeof(void*);
+
+    size_t objects = 0;
+    size_t bytes = 0;
+    size_t stringBytes = 0;  // heap payloads of strings, included in bytes
+
+    // Heap block of a string; short strings live inside the object and cost nothing extra
+    void addString(const std::string& value) {
+        static const size_t inlineCapacity = std::string().capacity();
+        if (value.capacity() > inlineCapacity) {
+            bytes += value.capacity() + 1;
+            stringBytes += value.capacity() + 1;
+        }
+    }
+
+    template <typename T>
+    void addVector(const std::vector<T>& values) {
+        bytes += values.capacity() * sizeof(T);
+    }
+
+    template <typename T>
+    void addDeque(const std::deque<T>& values) {
+        bytes += values.size() * sizeof(T);
+    }
+
+    template <typename Key, typename Value, typename Compare>
+    void addMap(const std::map<Key, Value, Compare>& values) {
+        bytes += values.size() * (sizeof(std::pair<const Key, Value>) + MAP_NODE_OVERHEAD);
+    }
+
+    template <typename Key, typename Value, typename Hash>
+    void addHashMap(const std::unordered_map<Key, Value, Hash>& values) {
+        bytes += values.bucket_count() * sizeof(void*) +
+                 values.size() * (sizeof(std::pair<const Key, Value>) + HASH_NODE_OVERHEAD);
+    }
+
+    void merge(const MemoryUsage& other) {
+        objects += other.objects;
+        bytes += other.bytes;
+        stringBytes += other.stringBytes;
+    }
+};
+
+// Named MemoryUsage entries, printable as a table
+class MemoryReport {
+   private:
+    std::vector<std::pair<std::string, MemoryUsage>> entries;
+
+   public:
+    void add(const std::string& name, const MemoryUsage& usage) {
+        entries.emplace_back(name, usage);
+    }
+
+    const std::vector<std::pair<std::string, MemoryUsage>>& getEntries() const {
+        return entries;
+    }
+
+    MemoryUsage total() const {
+        MemoryUsage sum;
+        for (const auto& entry : entries) sum.merge(entry.second);
+        return sum;
+    }
+
+    std::string format() const {
+        std::ostringstream out;
+        out << std::left << std::setw(30) << "subsystem" << std::right << std::setw(12)
+            << "objects" << std::setw(16) << "bytes" << std::setw(16) << "string_bytes"
+            << "\n";
+        auto line = [&out](const std::string& name, const MemoryUsage& usage) {
+            out << std::left << std::setw(30) << name << std::right << std::setw(12)
+                << usage.objects << std::setw(16) << usage.bytes << std::setw(16)
+                << usage.stringBytes << "\n";
+        };
+        for (const auto& entry : entries) line(entry.first, entry.second);
+        line("total", total());
+        return out.str();
+    }
+};
+
+#endif
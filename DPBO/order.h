@@ -0,0 +1,138 @@
+#ifndef ORDER_H
+#define ORDER_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+#include "memory_usage.h"
+#include "serialization.h"
+#include "transaction.h"
+
+struct OrderLine {
+    int itemId;
+    int quantity;
+    double unitPrice;
+
+    static constexpr auto serializationFields() {
+        return std::make_tuple(serialization::raw(&OrderLine::itemId),
+                               serialization::raw(&OrderLine::quantity),
+                               serialization::raw(&OrderLine::unitPrice));
+    }
+};
+
+// A cart of several items bought from one seller, committed by the Store as one unit.
+// Each line becomes one Transaction (amount = quantity * unitPrice) so per-item analytics
+// keep working, while the store log keeps a single record for the whole order.
+class Order {
+   private:
+    int id;
+    int buyerId;
+    int sellerId;
+    int firstTransactionId;
+    std::vector<OrderLine> lines;
+    TransactionStatus status;
+    std::chrono::system_clock::time_point timestamp;
+
+    friend struct SerializationAccess;
+
+    static constexpr auto serializationFields() {
+        return std::make_tuple(
+            serialization::raw(&Order::id), serialization::raw(&Order::buyerId),
+            serialization::raw(&Order::sellerId), serialization::raw(&Order::firstTransactionId),
+            serialization::asInt(&Order::status), serialization::time(&Order::timestamp),
+            serialization::list(&Order::lines));
+    }
+
+   public:
+    Order()
+        : id(0),
+          buyerId(0),
+          sellerId(0),
+          firstTransactionId(0),
+          status(TransactionStatus::PENDING),
+          timestamp(std::chrono::system_clock::now()) {}
+
+    // Pass the store clock's time as timestamp so simulated clocks replay deterministically
+    Order(int id, int buyerId, int sellerId,
+          std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now())
+        : id(id),
+          buyerId(buyerId),
+          sellerId(sellerId),
+          firstTransactionId(0),
+          status(TransactionStatus::PENDING),
+          timestamp(timestamp) {}
+
+    // Getters
+    int getId() const { return id; }
+    int getBuyerId() const { return buyerId; }
+    int getSellerId() const { return sellerId; }
+    int getFirstTransactionId() const { return firstTransactionId; }
+    const std::vector<OrderLine>& getLines() const { return lines; }
+    TransactionStatus getStatus() const { return status; }
+    std::chrono::system_clock::time_point getTimestamp() const { return timestamp; }
+
+    double getTotal() const {
+        double total = 0.0;
+        for (const auto& line : lines) total += line.quantity * line.unitPrice;
+        return total;
+    }
+
+    int getUnitCount() const {
+        int units = 0;
+        for (const auto& line : lines) units += line.quantity;
+        return units;
+    }
+
+    // Setters
+    void setStatus(TransactionStatus status) { this->status = status; }
+    void setFirstTransactionId(int transactionId) { firstTransactionId = transactionId; }
+    void setUnitPrice(size_t lineIndex, double price) { lines[lineIndex].unitPrice = price; }
+
+    // Line management
+    bool addLine(int itemId, int quantity) {
+        if (quantity <= 0) return false;
+        lines.push_back({itemId, quantity, 0.0});
+        return true;
+    }
+
+    // Sorts the lines by item id and merges lines for the same item
+    void normalize() {
+        std::sort(lines.begin(), lines.end(),
+                  [](const OrderLine& a, const OrderLine& b) { return a.itemId < b.itemId; });
+        size_t kept = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (kept > 0 && lines[kept - 1].itemId == lines[i].itemId) {
+                lines[kept - 1].quantity += lines[i].quantity;
+            } else {
+                lines[kept++] = lines[i];
+            }
+        }
+        lines.resize(kept);
+    }
+
+    // The per-line transaction of line lineIndex; ids follow firstTransactionId
+    Transaction lineTransaction(size_t lineIndex) const {
+        const OrderLine& line = lines[lineIndex];
+        Transaction transaction(firstTransactionId + static_cast<int>(lineIndex), buyerId,
+                                sellerId, line.itemId, line.quantity * line.unitPrice);
+        transaction.setStatus(status);
+        transaction.setTimestamp(timestamp);
+        transaction.setOrder(id, line.quantity);
+        return transaction;
+    }
+
+    // Heap memory owned by this order beyond sizeof(Order)
+    void addHeapUsage(MemoryUsage& usage) const { usage.addVector(lines); }
+
+    // Serialization
+    void serialize(std::ofstream& out) const { serialization::write(*this, out); }
+
+    bool deserialize(std::ifstream& in) {
+        serialization::read(*this, in);
+        return static_cast<bool>(in);
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PRICE_INDEX_H
+#define PRICE_INDEX_H
+
+#include <climits>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "item.h"
+
+// Receives price changes made outside the Store, e.g. by Seller::setItemPrice
+class PriceListener {
+   public:
+    virtual ~PriceListener() = default;
+    virtual void onPriceChanged(int itemId, double price) = 0;
+};
+
+// Position in a price-ordered listing: the last (price, item id) already returned
+struct PriceCursor {
+    double price = -std::numeric_limits<double>::infinity();
+    int itemId = INT_MIN;
+};
+
+// Items ordered by (price, id), once for the whole catalog and once for items in stock.
+// update() only touches the sets when the price or the in-stock flag actually changed,
+// so re-filing an item after every sale or repricing costs at most two O(log n) moves.
+class PriceIndex {
+   public:
+    using Key = std::pair<double, int>;
+    using Entries = std::set<Key>;
+
+   private:
+    struct State {
+        double price;
+        bool inStock;
+    };
+
+    Entries all;
+    Entries inStock;
+    std::unordered_map<int, State> states;
+
+   public:
+    // Registers an item, or re-files it if it is already indexed
+    void insert(const Item& item) { update(item); }
+
+    void update(const Item& item) {
+        State current{item.getPrice(), item.getStock() > 0};
+        auto it = states.find(item.getId());
+        if (it == states.end()) {
+            all.insert({current.price, item.getId()});
+            if (current.inStock) inStock.insert({current.price, item.getId()});
+            states.emplace(item.getId(), current);
+            return;
+        }
+
+        State& previous = it->second;
+        if (previous.price == current.price && previous.inStock == current.inStock) return;
+        if (previous.price != current.price) {
+            all.erase({previous.price, item.getId()});
+            all.insert({current.price, item.getId()});
+        }
+        if (previous.inStock) inStock.erase({previous.price, item.getId()});
+        if (current.inStock) inStock.insert({current.price, item.getId()});
+        previous = current;
+    }
+
+    void remove(int itemId) {
+        auto it = states.find(itemId);
+        if (it == states.end()) return;
+        all.erase({it->second.price, itemId});
+        if (it->second.inStock) inStock.erase({it->second.price, itemId});
+        states.erase(it);
+    }
+
+    // [first, last) of the entries priced within [minPrice, maxPrice] that come after cursor
+    std::pair<Entries::const_iterator, Entries::const_iterator> range(
+        double minPrice, double maxPrice, bool inStockOnly,
+        const PriceCursor& after = PriceCursor()) const {
+        const Entries& entries = inStockOnly ? inStock : all;
+        auto first = entries.lower_bound({minPrice, INT_MIN});
+        auto resume = entries.upper_bound({after.price, after.itemId});
+        if (resume == entries.end() || (first != entries.end() && *first < *resume)) {
+            first = resume;
+        }
+        auto last = entries.upper_bound({maxPrice, INT_MAX});
+        if (first == entries.end() || (last != entries.end() && *last < *first)) last = first;
+        return {first, last};
+    }
+
+    size_t countInRange(double minPrice, double maxPrice, bool inStockOnly) const {
+        auto bounds = range(minPrice, maxPrice, inStockOnly);
+        size_t count = 0;
+        for (auto it = bounds.first; it != bounds.second; ++it) count++;
+        return count;
+    }
+
+    size_t size() const { return all.size(); }
+    size_t inStockCount() const { return inStock.size(); }
+};
+
+// Projection for query views over PriceIndex entries
+struct PriceEntryProjection {
+    const std::map<int, Item>* items;
+
+    const Item& operator()(const PriceIndex::Key& entry) const {
+        return items->at(entry.second);
+    }
+};
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+// KLL quantile sketch over doubles.
+// Values go into level 0; when a level outgrows its capacity it is sorted and every other
+// value (random offset) moves one level up with twice the weight. Capacities shrink by 2/3
+// per level below the top, so the sketch holds at most about 3k values whatever the volume
+// (under 5 KB for the default k = 200); rank errors are typically within 2/k of the count.
+// Sketches built on different threads or shards merge into one.
+class QuantileSketch {
+   private:
+    int k;
+    uint64_t count;
+    double minValue;
+    double maxValue;
+    uint64_t randomState;
+    std::vector<std::vector<double>> levels;
+
+    size_t capacity(size_t level) const {
+        size_t depth = levels.size() - level - 1;
+        double scaled = k * std::pow(2.0 / 3.0, static_cast<double>(depth));
+        return std::max<size_t>(2, static_cast<size_t>(std::ceil(scaled)));
+    }
+
+    bool randomBit() {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return randomState & 1;
+    }
+
+    void compress() {
+        for (size_t level = 0; level < levels.size(); level++) {
+            if (levels[level].size() < capacity(level)) continue;
+            if (level + 1 == levels.size()) levels.emplace_back();
+
+            std::vector<double>& values = levels[level];
+            std::sort(values.begin(), values.end());
+            // An odd value out stays behind so the total weight is preserved
+            double leftover = 0.0;
+            bool hasLeftover = values.size() % 2 == 1;
+            if (hasLeftover) {
+                leftover = values.back();
+                values.pop_back();
+            }
+            for (size_t i = randomBit() ? 1 : 0; i < values.size(); i += 2) {
+                levels[level + 1].push_back(values[i]);
+            }
+            values.clear();
+            if (hasLeftover) values.push_back(leftover);
+        }
+    }
+
+   public:
+    explicit QuantileSketch(int k = 200)
+        : k(std::max(k, 8)),
+          count(0),
+          minValue(std::numeric_limits<double>::infinity()),
+          maxValue(-std::numeric_limits<double>::infinity()),
+          randomState(0x9E3779B97F4A7C15ull),
+          levels(1) {}
+
+    void add(double value) {
+        levels[0].push_back(value);
+        count++;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+        if (levels[0].size() >= capacity(0)) compress();
+    }
+
+    void merge(const QuantileSketch& other) {
+        if (other.count == 0) return;
+        while (levels.size() < other.levels.size()) levels.emplace_back();
+        for (size_t level = 0; level < other.levels.size(); level++) {
+            levels[level].insert(levels[level].end(), other.levels[level].begin(),
+                                 other.levels[level].end());
+        }
+        count += other.count;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        compress();
+    }
+
+    // Value at rank fraction q in [0, 1]; 0 when the sketch is empty
+    double quantile(double q) const {
+        if (count == 0) return 0.0;
+        if (q <= 0.0) return minValue;
+        if (q >= 1.0) return maxValue;
+
+        std::vector<std::pair<double, uint64_t>> weighted;
+        uint64_t totalWeight = 0;
+        for (size_t level = 0; level < levels.size(); level++) {
+            for (double value : levels[level]) {
+                weighted.emplace_back(value, uint64_t(1) << level);
+                totalWeight += uint64_t(1) << level;
+            }
+        }
+        std::sort(weighted.begin(), weighted.end());
+
+        double target = q * totalWeight;
+        uint64_t cumulative = 0;
+        for (const auto& pair : weighted) {
+            cumulative += pair.second;
+            if (cumulative >= target) return pair.first;
+        }
+        return maxValue;
+    }
+
+    uint64_t getCount() const { return count; }
+    double getMin() const { return count ? minValue : 0.0; }
+    double getMax() const { return count ? maxValue : 0.0; }
+
+    size_t retainedValues() const {
+        size_t retained = 0;
+        for (const auto& level : levels) retained += level.size();
+        return retained;
+    }
+
+    // "p50 <v> p90 <v> p99 <v> (n <count>)"
+    std::string summary() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << "p50 " << quantile(0.5) << " p90 "
+            << quantile(0.9) << " p99 " << quantile(0.99) << " (n " << count << ")";
+        return out.str();
+    }
+
+    // k, count, min, max and random state, then the level count and each level's values
+    void serialize(std::ofstream& out) const {
+        out.write(reinterpret_cast<const char*>(&k), sizeof(k));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&minValue), sizeof(minValue));
+        out.write(reinterpret_cast<const char*>(&maxValue), sizeof(maxValue));
+        out.write(reinterpret_cast<const char*>(&randomState), sizeof(randomState));
+        size_t levelCount = levels.size();
+        out.write(reinterpret_cast<const char*>(&levelCount), sizeof(levelCount));
+        for (const auto& level : levels) {
+            size_t size = level.size();
+            out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            out.write(reinterpret_cast<const char*>(level.data()), size * sizeof(double));
+        }
+    }
+
+    bool deserialize(std::ifstream& in) {
+        QuantileSketch loaded;
+        size_t levelCount = 0;
+        in.read(reinterpret_cast<char*>(&loaded.k), sizeof(loaded.k));
+        in.read(reinterpret_cast<char*>(&loaded.count), sizeof(loaded.count));
+        in.read(reinterpret_cast<char*>(&loaded.minValue), sizeof(loaded.minValue));
+        in.read(reinterpret_cast<char*>(&loaded.maxValue), sizeof(loaded.maxValue));
+        in.read(reinterpret_cast<char*>(&loaded.randomState), sizeof(loaded.randomState));
+        if (!in.read(reinterpret_cast<char*>(&levelCount), sizeof(levelCount))) return false;
+        loaded.levels.assign(std::max<size_t>(levelCount, 1), {});
+        for (size_t i = 0; i < levelCount; i++) {
+            size_t size = 0;
+            if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) return false;
+            loaded.levels[i].resize(size);
+            if (!in.read(reinterpret_cast<char*>(loaded.levels[i].data()),
+                         size * sizeof(double))) {
+                return false;
+            }
+        }
+        *this = std::move(loaded);
+        return true;
+    }
+};
+
+// One QuantileSketch per key (day, seller, tier, ...). With a key limit, adding a new
+// key beyond the limit drops the smallest key, which keeps a rolling set of days.
+template <typename Key>
+class KeyedQuantiles {
+   private:
+    std::map<Key, QuantileSketch> sketches;
+    size_t maxKeys;
+
+   public:
+    explicit KeyedQuantiles(size_t maxKeys = std::numeric_limits<size_t>::max())
+        : maxKeys(maxKeys) {}
+
+    void add(const Key& key, double value) {
+        auto it = sketches.find(key);
+        if (it == sketches.end()) {
+            if (sketches.size() >= maxKeys) {
+                if (key < sketches.begin()->first) return;  // older than everything kept
+                sketches.erase(sketches.begin());
+            }
+            it = sketches.emplace(key, QuantileSketch()).first;
+        }
+        it->second.add(value);
+    }
+
+    void merge(const KeyedQuantiles& other) {
+        for (const auto& pair : other.sketches) sketches[pair.first].merge(pair.second);
+        while (sketches.size() > maxKeys) sketches.erase(sketches.begin());
+    }
+
+    const QuantileSketch* find(const Key& key) const {
+        auto it = sketches.find(key);
+        return it != sketches.end() ? &it->second : nullptr;
+    }
+
+    // Sketch of every key in [first, last]
+    QuantileSketch mergedRange(const Key& first, const Key& last) const {
+        QuantileSketch merged;
+        for (auto it = sketches.lower_bound(first); it != sketches.end() && !(last < it->first);
+             ++it) {
+            merged.merge(it->second);
+        }
+        return merged;
+    }
+
+    typename std::map<Key, QuantileSketch>::const_iterator begin() const {
+        return sketches.begin();
+    }
+    typename std::map<Key, QuantileSketch>::const_iterator end() const { return sketches.end(); }
+    size_t size() const { return sketches.size(); }
+
+    void addMemoryUsage(MemoryUsage& usage) const {
+        usage.objects += sketches.size();
+        usage.addMap(sketches);
+        for (const auto& pair : sketches) {
+            usage.bytes += pair.second.retainedValues() * sizeof(double);
+        }
+    }
+
+    // Key count, then each key followed by its sketch; keys must be trivially copyable
+    void serialize(std::ofstream& out) const {
+        size_t count = sketches.size();
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& pair : sketches) {
+            out.write(reinterpret_cast<const char*>(&pair.first), sizeof(Key));
+            pair.second.serialize(out);
+        }
+    }
+
+    // Replaces the current sketches; false (and unchanged) when the block is missing
+    bool deserialize(std::ifstream& in) {
+        size_t count = 0;
+        if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+        std::map<Key, QuantileSketch> loaded;
+        for (size_t i = 0; i < count; i++) {
+            Key key;
+            if (!in.read(reinterpret_cast<char*>(&key), sizeof(Key))) return false;
+            if (!loaded[key].deserialize(in)) return false;
+        }
+        sketches = std::move(loaded);
+        while (sketches.size() > maxKeys) sketches.erase(sketches.begin());
+        return true;
+    }
+};
+
+// Days since the epoch (UTC) of a time point, the key of daily sketches
+inline int64_t dayOf(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::hours>(time.time_since_epoch()).count() / 24;
+}
+
+#endif
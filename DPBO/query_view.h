@@ -0,0 +1,202 @@
+#ifndef QUERY_VIEW_H
+#define QUERY_VIEW_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Lazy, non-owning query views over the internal storage of Bank, Store, Buyer and Seller.
+// A view holds an iterator range, a projection from the underlying element to the record
+// and a filter. Nothing is copied until toVector() is called; sortedBy() materializes
+// pointers only.
+
+// Yields the element itself
+struct IdentityProjection {
+    template <typename T>
+    const T& operator()(const T& value) const {
+        return value;
+    }
+};
+
+// Yields the mapped value of a std::map entry
+struct MappedValueProjection {
+    template <typename Pair>
+    const typename Pair::second_type& operator()(const Pair& pair) const {
+        return pair.second;
+    }
+};
+
+// Yields the element stored at a position of a random-access container
+template <typename Container>
+struct PositionProjection {
+    const Container* container;
+
+    const typename Container::value_type& operator()(size_t position) const {
+        return (*container)[position];
+    }
+};
+
+struct AcceptAll {
+    template <typename T>
+    bool operator()(const T&) const {
+        return true;
+    }
+};
+
+template <typename First, typename Second>
+struct BothPredicates {
+    First first;
+    Second second;
+
+    template <typename T>
+    bool operator()(const T& value) const {
+        return first(value) && second(value);
+    }
+};
+
+template <typename Iterator, typename Projection = IdentityProjection,
+          typename Predicate = AcceptAll>
+class QueryView {
+   public:
+    using value_type = std::decay_t<decltype(std::declval<const Projection&>()(
+        *std::declval<const Iterator&>()))>;
+
+   private:
+    Iterator first;
+    Iterator last;
+    Projection project;
+    Predicate predicate;
+    size_t maxCount;
+
+   public:
+    class iterator {
+       private:
+        const QueryView* view;
+        Iterator current;
+        size_t remaining;
+
+        void skipRejected() {
+            while (remaining > 0 && current != view->last &&
+                   !view->predicate(view->project(*current))) {
+                ++current;
+            }
+        }
+
+        bool atEnd() const { return remaining == 0 || current == view->last; }
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename QueryView::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        iterator(const QueryView* view, Iterator current, size_t remaining)
+            : view(view), current(current), remaining(remaining) {
+            skipRejected();
+        }
+
+        reference operator*() const { return view->project(*current); }
+        pointer operator->() const { return &view->project(*current); }
+
+        iterator& operator++() {
+            ++current;
+            remaining--;
+            skipRejected();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const {
+            if (atEnd() || other.atEnd()) return atEnd() == other.atEnd();
+            return current == other.current;
+        }
+
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    QueryView(Iterator first, Iterator last, Projection project = Projection(),
+              Predicate predicate = Predicate(),
+              size_t maxCount = std::numeric_limits<size_t>::max())
+        : first(first), last(last), project(project), predicate(predicate), maxCount(maxCount) {}
+
+    iterator begin() const { return iterator(this, first, maxCount); }
+    iterator end() const { return iterator(this, last, 0); }
+
+    // Adds a filter on top of the existing ones
+    template <typename Filter>
+    QueryView<Iterator, Projection, BothPredicates<Predicate, Filter>> where(Filter filter) const {
+        return {first, last, project, {predicate, filter}, maxCount};
+    }
+
+    // Stops after n matching records
+    QueryView limit(size_t n) const {
+        return QueryView(first, last, project, predicate, std::min(n, maxCount));
+    }
+
+    template <typename Function>
+    void forEach(Function function) const {
+        for (const auto& record : *this) function(record);
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (auto it = begin(); it != end(); ++it) total++;
+        return total;
+    }
+
+    bool empty() const { return begin() == end(); }
+
+    // Copies the matching records
+    std::vector<value_type> toVector() const {
+        std::vector<value_type> records;
+        for (const auto& record : *this) records.push_back(record);
+        return records;
+    }
+
+    // Handles to the matching records, in view order
+    std::vector<const value_type*> toPointers() const {
+        std::vector<const value_type*> handles;
+        for (const auto& record : *this) handles.push_back(&record);
+        return handles;
+    }
+
+    // Handles to the first n records ordered by key (ascending unless descending is set).
+    // Each key is computed once per record.
+    template <typename KeyFunction>
+    std::vector<const value_type*> sortedBy(KeyFunction key,
+                                            size_t n = std::numeric_limits<size_t>::max(),
+                                            bool descending = false) const {
+        using Key = std::decay_t<decltype(key(std::declval<const value_type&>()))>;
+        std::vector<std::pair<Key, const value_type*>> keyed;
+        for (const auto& record : *this) keyed.emplace_back(key(record), &record);
+
+        auto order = [descending](const auto& a, const auto& b) {
+            return descending ? b.first < a.first : a.first < b.first;
+        };
+        n = std::min(n, keyed.size());
+        std::partial_sort(keyed.begin(), keyed.begin() + n, keyed.end(), order);
+
+        std::vector<const value_type*> handles;
+        handles.reserve(n);
+        for (size_t i = 0; i < n; i++) handles.push_back(keyed[i].second);
+        return handles;
+    }
+};
+
+template <typename Iterator, typename Projection = IdentityProjection>
+QueryView<Iterator, Projection> makeQueryView(Iterator first, Iterator last,
+                                              Projection project = Projection()) {
+    return QueryView<Iterator, Projection>(first, last, project);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SALES_RANKING_H
+#define SALES_RANKING_H
+
+#include <algorithm>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "item.h"
+
+// Best-seller ranking kept in sync with Item::soldCount.
+// Entries are keyed by (-soldCount, itemId) in an order-statistic tree, so walking the
+// tree from the front yields the top sellers and the rank of an item is a single lookup.
+// Only ids are held, so the ranking stays valid when the owning Store is copied.
+class SalesRanking {
+   private:
+    using Key = std::pair<int, int>;
+    using Tree = __gnu_pbds::tree<Key, __gnu_pbds::null_type, std::less<Key>,
+                                  __gnu_pbds::rb_tree_tag,
+                                  __gnu_pbds::tree_order_statistics_node_update>;
+
+    Tree ranking;
+    std::unordered_map<int, int> soldCounts;
+
+   public:
+    // Registers an item, or re-files it if it is already ranked
+    void insert(const Item& item) {
+        remove(item.getId());
+        ranking.insert({-item.getSoldCount(), item.getId()});
+        soldCounts[item.getId()] = item.getSoldCount();
+    }
+
+    // Re-files an item after its soldCount changed
+    void update(const Item& item) {
+        auto it = soldCounts.find(item.getId());
+        if (it == soldCounts.end()) {
+            insert(item);
+            return;
+        }
+        if (it->second == item.getSoldCount()) return;
+
+        ranking.erase({-it->second, item.getId()});
+        ranking.insert({-item.getSoldCount(), item.getId()});
+        it->second = item.getSoldCount();
+    }
+
+    void remove(int itemId) {
+        auto it = soldCounts.find(itemId);
+        if (it != soldCounts.end()) {
+            ranking.erase({-it->second, itemId});
+            soldCounts.erase(it);
+        }
+    }
+
+    // Ids of the top sellers, best first. Costs O(count) after the first step.
+    std::vector<int> top(int count) const {
+        std::vector<int> result;
+        if (count <= 0) return result;
+        result.reserve(std::min<size_t>(count, ranking.size()));
+        for (auto it = ranking.begin(); it != ranking.end() && (int)result.size() < count; ++it) {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+
+    // 1-based position in the ranking, or 0 when the item is not ranked
+    int rankOf(int itemId) const {
+        auto it = soldCounts.find(itemId);
+        if (it == soldCounts.end()) return 0;
+        return ranking.order_of_key({-it->second, itemId}) + 1;
+    }
+
+    size_t size() const { return ranking.size(); }
+
+    void clear() {
+        ranking.clear();
+        soldCounts.clear();
+    }
+};
+
+#endif
@@ -44,30 +44,28 @@ bool Seller::setItemPrice(int itemId, double price) {
                            [itemId](const Item& i) { return i.getId() == itemId; });
     if (it != items.end()) {
         it->setPrice(price);
+        if (priceListener) priceListener->onPriceChanged(itemId, price);
         return true;
     }
     return false;
 }
 
 std::vector<Item> Seller::getMonthlyPopularItems() const {
-    std::vector<Item> monthlyItems = items;
-    auto now = std::chrono::system_clock::now();
-
-    // Sort by monthly sales
-    std::sort(monthlyItems.begin(), monthlyItems.end(), [this, now](const Item& a, const Item& b) {
-        return getMonthlyItemSales(a.getId()) > getMonthlyItemSales(b.getId());
-    });
-
+    std::vector<Item> monthlyItems;
+    for (const Item* item : getMonthlyPopularItemHandles()) {
+        monthlyItems.push_back(*item);
+    }
     return monthlyItems;
 }
 
-int Seller::getMonthlyItemSales(int itemId) const {
-    auto now = std::chrono::system_clock::now();
-    return std::count_if(
-        transactions.begin(), transactions.end(), [itemId, now](const Transaction& t) {
-            auto diff =
-                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
-            return diff <= (30 * 24) && t.getItemId() == itemId &&
-                   t.getStatus() == TransactionStatus::COMPLETED;
-        });
+int Seller::getMonthlyItemSales(int itemId, std::chrono::system_clock::time_point now) const {
+    int sales = 0;
+    for (const auto& t : transactions) {
+        auto diff = std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
+        if (diff <= (30 * 24) && t.getItemId() == itemId &&
+            t.getStatus() == TransactionStatus::COMPLETED) {
+            sales += t.getQuantity();
+        }
+    }
+    return sales;
 }
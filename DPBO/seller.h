@@ -3,11 +3,16 @@
 
 #include <algorithm>
 #include <chrono>
-#include <map>
+#include <limits>
+#include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "bank_customer.h"
 #include "item.h"
+#include "price_index.h"
+#include "query_view.h"
 #include "transaction.h"
 #include "user.h"
 
@@ -17,16 +22,49 @@ class Seller : public User {
     std::vector<Transaction> transactions;
 
     struct CustomerStats {
-        int purchaseCount;
-        double totalAmount;
-        std::chrono::system_clock::time_point lastPurchase;
+        int purchaseCount = 0;
+        double totalAmount = 0.0;
+        std::chrono::system_clock::time_point lastPurchase{};
     };
 
+    // Per-buyer stats over COMPLETED transactions, maintained as transactions arrive
+    std::unordered_map<int, CustomerStats> customerStats;
+    std::unordered_map<int, size_t> transactionPositions;
+    PriceListener* priceListener = nullptr;
+    BankCustomer* bankAccount = nullptr;  // receives checkout payments
+
+    void applyCompletedTransaction(const Transaction& transaction, int direction) {
+        auto& stats = customerStats[transaction.getBuyerId()];
+        stats.purchaseCount += direction;
+        stats.totalAmount += direction * transaction.getAmount();
+        if (direction > 0 && transaction.getTimestamp() > stats.lastPurchase) {
+            stats.lastPurchase = transaction.getTimestamp();
+        }
+        if (stats.purchaseCount <= 0) {
+            customerStats.erase(transaction.getBuyerId());
+        }
+    }
+
+    // True when buyer a ranks above buyer b in the loyalty order
+    static bool isMoreLoyal(const std::pair<int, CustomerStats>& a,
+                            const std::pair<int, CustomerStats>& b) {
+        if (a.second.purchaseCount != b.second.purchaseCount)
+            return a.second.purchaseCount > b.second.purchaseCount;
+        if (a.second.totalAmount != b.second.totalAmount)
+            return a.second.totalAmount > b.second.totalAmount;
+        return a.first < b.first;
+    }
+
    public:
     Seller() : User() {}
 
     Seller(int id, std::string name) : User(id, name) {}
 
+    // Bank account management
+    void createBankAccount(BankCustomer* account) { this->bankAccount = account; }
+    bool hasBankAccount() const { return bankAccount != nullptr; }
+    const BankCustomer* getBankAccount() const { return bankAccount; }
+
     // Item management
     bool addItem(const Item& item) {
         auto it = std::find_if(items.begin(), items.end(),
@@ -63,61 +101,113 @@ class Seller : public User {
                                [itemId](const Item& i) { return i.getId() == itemId; });
         if (it != items.end()) {
             it->setPrice(price);
+            if (priceListener) priceListener->onPriceChanged(itemId, price);
             return true;
         }
         return false;
     }
 
-    // Transaction management
-    void addTransaction(const Transaction& transaction) { transactions.push_back(transaction); }
+    // Notified on every setItemPrice; the Store attaches itself here
+    void setPriceListener(PriceListener* listener) { priceListener = listener; }
 
-    // Analytics
-    std::vector<Item> getMonthlyPopularItems() const {
-        std::vector<Item> monthlyItems = items;
-        auto now = std::chrono::system_clock::now();
+    bool renameItem(int itemId, const std::string& name) {
+        auto it = std::find_if(items.begin(), items.end(),
+                               [itemId](const Item& i) { return i.getId() == itemId; });
+        if (it != items.end()) {
+            it->setName(name);
+            return true;
+        }
+        return false;
+    }
+
+    // Transaction management
+    void addTransaction(const Transaction& transaction) {
+        transactionPositions[transaction.getId()] = transactions.size();
+        transactions.push_back(transaction);
+        if (transaction.getStatus() == TransactionStatus::COMPLETED) {
+            applyCompletedTransaction(transaction, 1);
+        }
+    }
 
-        // Sort by monthly sales
-        std::sort(monthlyItems.begin(), monthlyItems.end(),
-                  [this, now](const Item& a, const Item& b) {
-                      return getMonthlyItemSales(a.getId()) > getMonthlyItemSales(b.getId());
-                  });
+    bool updateTransactionStatus(int transactionId, TransactionStatus status) {
+        auto it = transactionPositions.find(transactionId);
+        if (it == transactionPositions.end()) return false;
+
+        Transaction& transaction = transactions[it->second];
+        bool wasCompleted = transaction.getStatus() == TransactionStatus::COMPLETED;
+        bool isCompleted = status == TransactionStatus::COMPLETED;
+        transaction.setStatus(status);
+        if (!wasCompleted && isCompleted) applyCompletedTransaction(transaction, 1);
+        if (wasCompleted && !isCompleted) applyCompletedTransaction(transaction, -1);
+        return true;
+    }
 
-        return monthlyItems;
+    // Lazy views over the seller's items and transactions
+    auto itemsView() const { return makeQueryView(items.begin(), items.end()); }
+    auto transactionsView() const {
+        return makeQueryView(transactions.begin(), transactions.end());
     }
 
-    std::vector<int> getLoyalCustomers() const {
-        std::map<int, CustomerStats> customerStats;
-        auto now = std::chrono::system_clock::now();
+    // Handles to the n best-selling items of the 30 days before now, best first
+    std::vector<const Item*> getMonthlyPopularItemHandles(
+        size_t n = std::numeric_limits<size_t>::max(),
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const {
+        std::unordered_map<int, int> monthlySales = getMonthlySalesByItem(now);
+        return itemsView().sortedBy(
+            [&monthlySales](const Item& item) {
+                auto it = monthlySales.find(item.getId());
+                return it != monthlySales.end() ? it->second : 0;
+            },
+            n, true);
+    }
 
-        // Calculate customer statistics
-        for (const auto& transaction : transactions) {
-            if (transaction.getStatus() == TransactionStatus::COMPLETED) {
-                auto& stats = customerStats[transaction.getBuyerId()];
-                stats.purchaseCount++;
-                stats.totalAmount += transaction.getAmount();
-                stats.lastPurchase = transaction.getTimestamp();
-            }
+    // Analytics
+    std::vector<Item> getMonthlyPopularItems() const {
+        std::vector<Item> monthlyItems;
+        for (const Item* item : getMonthlyPopularItemHandles()) {
+            monthlyItems.push_back(*item);
         }
+        return monthlyItems;
+    }
 
-        // Sort customers by purchase count and total amount
-        std::vector<std::pair<int, CustomerStats>> sortedCustomers(customerStats.begin(),
-                                                                   customerStats.end());
-
-        std::sort(sortedCustomers.begin(), sortedCustomers.end(), [](const auto& a, const auto& b) {
-            if (a.second.purchaseCount == b.second.purchaseCount)
-                return a.second.totalAmount > b.second.totalAmount;
-            return a.second.purchaseCount > b.second.purchaseCount;
-        });
+    std::vector<int> getLoyalCustomers() const { return getLoyalCustomers(customerStats.size()); }
 
-        // Extract customer IDs
+    // Top n buyers by completed purchase count, then total amount.
+    // Uses a heap bounded to n entries, so the cost depends on the number of buyers only.
+    std::vector<int> getLoyalCustomers(size_t n) const {
+        using Entry = std::pair<int, CustomerStats>;
         std::vector<int> loyalCustomerIds;
-        for (const auto& pair : sortedCustomers) {
-            loyalCustomerIds.push_back(pair.first);
+        if (n == 0) return loyalCustomerIds;
+
+        // Min-heap on loyalty: the least loyal of the current top n sits on top
+        std::priority_queue<Entry, std::vector<Entry>, decltype(&isMoreLoyal)> heap(&isMoreLoyal);
+        for (const auto& pair : customerStats) {
+            if (heap.size() < n) {
+                heap.push(pair);
+            } else if (isMoreLoyal(pair, heap.top())) {
+                heap.pop();
+                heap.push(pair);
+            }
         }
 
+        loyalCustomerIds.resize(heap.size());
+        for (size_t i = heap.size(); i-- > 0;) {
+            loyalCustomerIds[i] = heap.top().first;
+            heap.pop();
+        }
         return loyalCustomerIds;
     }
 
+    // Memory held by the seller beyond sizeof(Seller)
+    void addMemoryUsage(MemoryUsage& usage) const {
+        addHeapUsage(usage);
+        usage.addVector(items);
+        for (const auto& item : items) item.addHeapUsage(usage);
+        usage.addVector(transactions);
+        usage.addHashMap(transactionPositions);
+        usage.addHashMap(customerStats);
+    }
+
     // Override base class methods
     std::string getInfo() const override {
         std::string info = User::getInfo();
@@ -127,15 +217,31 @@ class Seller : public User {
     }
 
    private:
-    int getMonthlyItemSales(int itemId) const {
-        auto now = std::chrono::system_clock::now();
-        return std::count_if(
-            transactions.begin(), transactions.end(), [itemId, now](const Transaction& t) {
-                auto diff =
-                    std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
-                return diff <= (30 * 24) && t.getItemId() == itemId &&
-                       t.getStatus() == TransactionStatus::COMPLETED;
-            });
+    // Completed sales of the last 30 days per item id, in one pass over the transactions
+    std::unordered_map<int, int> getMonthlySalesByItem(
+        std::chrono::system_clock::time_point now) const {
+        std::unordered_map<int, int> sales;
+        for (const auto& t : transactions) {
+            auto diff =
+                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
+            if (diff <= (30 * 24) && t.getStatus() == TransactionStatus::COMPLETED) {
+                sales[t.getItemId()] += t.getQuantity();
+            }
+        }
+        return sales;
+    }
+
+    int getMonthlyItemSales(int itemId, std::chrono::system_clock::time_point now) const {
+        int sales = 0;
+        for (const auto& t : transactions) {
+            auto diff =
+                std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
+            if (diff <= (30 * 24) && t.getItemId() == itemId &&
+                t.getStatus() == TransactionStatus::COMPLETED) {
+                sales += t.getQuantity();
+            }
+        }
+        return sales;
     }
 };
 
@@ -0,0 +1,308 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary records generated from per-class field lists.
+// A serializable class lists its fields, in file order, in a private
+//     static constexpr auto serializationFields()
+// returning a tuple of the descriptors below, and befriends SerializationAccess. The
+// encoder and decoder are generated from that tuple at compile time. Consecutive
+// fixed-size fields form a run: the encoder reserves the whole run in the record buffer
+// once, and the decoder fills it with a single read. A record, nested records included,
+// reaches the stream with a single write.
+
+struct SerializationAccess {
+    template <typename Object>
+    static constexpr auto fields() {
+        return Object::serializationFields();
+    }
+};
+
+namespace serialization {
+
+// Record buffer; bytes reach the stream only on flushTo()
+class BinaryWriter {
+   private:
+    std::vector<char> buffer;
+
+   public:
+    // Appends n bytes and returns where to put them
+    char* extend(size_t n) {
+        size_t size = buffer.size();
+        buffer.resize(size + n);
+        return buffer.data() + size;
+    }
+
+    void flushTo(std::ostream& out) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+};
+
+// Field descriptors.
+// Fixed-size descriptors have size, encode(object, out) and decode(object, in).
+// Variable-size descriptors have write(object, writer) and read(object, stream).
+
+// A trivially copyable member, stored as its bytes
+template <typename Class, typename T>
+struct RawField {
+    static_assert(std::is_trivially_copyable<T>::value, "RawField needs a trivially copyable type");
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+    T Class::*member;
+
+    void encode(const Class& object, char* out) const {
+        std::memcpy(out, &(object.*member), size);
+    }
+    void decode(Class& object, const char* in) const { std::memcpy(&(object.*member), in, size); }
+};
+
+// An enum member, stored as int
+template <typename Class, typename Enum>
+struct EnumField {
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(int);
+    Enum Class::*member;
+
+    void encode(const Class& object, char* out) const {
+        int value = static_cast<int>(object.*member);
+        std::memcpy(out, &value, size);
+    }
+    void decode(Class& object, const char* in) const {
+        int value;
+        std::memcpy(&value, in, size);
+        object.*member = static_cast<Enum>(value);
+    }
+};
+
+// A system_clock::time_point member, stored as its tick count
+template <typename Class>
+struct TimeField {
+    using Rep = std::chrono::system_clock::duration::rep;
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(Rep);
+    std::chrono::system_clock::time_point Class::*member;
+
+    void encode(const Class& object, char* out) const {
+        Rep ticks = (object.*member).time_since_epoch().count();
+        std::memcpy(out, &ticks, size);
+    }
+    void decode(Class& object, const char* in) const {
+        Rep ticks;
+        std::memcpy(&ticks, in, size);
+        object.*member =
+            std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks));
+    }
+};
+
+// A fixed-size value read and written through accessors, for state that is not a plain
+// member (atomics, values with side effects on assignment)
+template <typename Class, typename T>
+struct PropertyField {
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+    T (*get)(const Class&);
+    void (*set)(Class&, T);
+
+    void encode(const Class& object, char* out) const {
+        T value = get(object);
+        std::memcpy(out, &value, size);
+    }
+    void decode(Class& object, const char* in) const {
+        T value;
+        std::memcpy(&value, in, size);
+        set(object, value);
+    }
+};
+
+// A std::string member, stored as an int length followed by the characters
+template <typename Class>
+struct StringField {
+    static constexpr bool fixed = false;
+    std::string Class::*member;
+
+    void write(const Class& object, BinaryWriter& writer) const {
+        const std::string& value = object.*member;
+        int length = static_cast<int>(value.size());
+        char* out = writer.extend(sizeof(length) + value.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), value.data(), value.size());
+    }
+    void read(Class& object, std::istream& in) const {
+        int length = 0;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::string& value = object.*member;
+        value.resize(in && length > 0 ? length : 0);
+        in.read(&value[0], value.size());
+    }
+};
+
+// A std::vector of serializable records, stored as a size_t count followed by the records
+template <typename Class, typename Element>
+struct ListField {
+    static constexpr bool fixed = false;
+    std::vector<Element> Class::*member;
+
+    void write(const Class& object, BinaryWriter& writer) const;
+    void read(Class& object, std::istream& in) const;
+};
+
+// Descriptor factories
+template <typename Class, typename T>
+constexpr RawField<Class, T> raw(T Class::*member) {
+    return {member};
+}
+
+template <typename Class, typename Enum>
+constexpr EnumField<Class, Enum> asInt(Enum Class::*member) {
+    return {member};
+}
+
+template <typename Class>
+constexpr TimeField<Class> time(std::chrono::system_clock::time_point Class::*member) {
+    return {member};
+}
+
+template <typename Class, typename T>
+constexpr PropertyField<Class, T> property(T (*get)(const Class&), void (*set)(Class&, T)) {
+    return {get, set};
+}
+
+template <typename Class>
+constexpr StringField<Class> string(std::string Class::*member) {
+    return {member};
+}
+
+template <typename Class, typename Element>
+constexpr ListField<Class, Element> list(std::vector<Element> Class::*member) {
+    return {member};
+}
+
+// Generated encoder and decoder
+namespace detail {
+
+template <typename Fields, size_t I>
+using FieldAt = std::decay_t<std::tuple_element_t<I, Fields>>;
+
+// One past the last field of the fixed-size run starting at I
+template <typename Fields, size_t I>
+constexpr size_t runEnd() {
+    if constexpr (I < std::tuple_size<Fields>::value) {
+        if constexpr (FieldAt<Fields, I>::fixed) return runEnd<Fields, I + 1>();
+    }
+    return I;
+}
+
+template <typename Fields, size_t I, size_t End>
+constexpr size_t runBytes() {
+    if constexpr (I < End) {
+        return FieldAt<Fields, I>::size + runBytes<Fields, I + 1, End>();
+    }
+    return 0;
+}
+
+template <size_t I, size_t End, typename Object, typename Fields>
+void encodeRun(const Object& object, const Fields& fields, char* out) {
+    if constexpr (I < End) {
+        std::get<I>(fields).encode(object, out);
+        encodeRun<I + 1, End>(object, fields, out + FieldAt<Fields, I>::size);
+    }
+}
+
+template <size_t I, size_t End, typename Object, typename Fields>
+void decodeRun(Object& object, const Fields& fields, const char* in) {
+    if constexpr (I < End) {
+        std::get<I>(fields).decode(object, in);
+        decodeRun<I + 1, End>(object, fields, in + FieldAt<Fields, I>::size);
+    }
+}
+
+template <size_t I, typename Object, typename Fields>
+void encodeFrom(const Object& object, const Fields& fields, BinaryWriter& writer) {
+    if constexpr (I < std::tuple_size<Fields>::value) {
+        if constexpr (FieldAt<Fields, I>::fixed) {
+            constexpr size_t end = runEnd<Fields, I>();
+            encodeRun<I, end>(object, fields, writer.extend(runBytes<Fields, I, end>()));
+            encodeFrom<end>(object, fields, writer);
+        } else {
+            std::get<I>(fields).write(object, writer);
+            encodeFrom<I + 1>(object, fields, writer);
+        }
+    }
+}
+
+template <size_t I, typename Object, typename Fields>
+void decodeFrom(Object& object, const Fields& fields, std::istream& in) {
+    if constexpr (I < std::tuple_size<Fields>::value) {
+        if constexpr (FieldAt<Fields, I>::fixed) {
+            constexpr size_t end = runEnd<Fields, I>();
+            char run[runBytes<Fields, I, end>()];
+            if (!in.read(run, sizeof(run))) return;
+            decodeRun<I, end>(object, fields, run);
+            decodeFrom<end>(object, fields, in);
+        } else {
+            std::get<I>(fields).read(object, in);
+            decodeFrom<I + 1>(object, fields, in);
+        }
+    }
+}
+
+}  // namespace detail
+
+template <typename Object>
+void encode(const Object& object, BinaryWriter& writer) {
+    detail::encodeFrom<0>(object, SerializationAccess::fields<Object>(), writer);
+}
+
+template <typename Object>
+void decode(Object& object, std::istream& in) {
+    detail::decodeFrom<0>(object, SerializationAccess::fields<Object>(), in);
+}
+
+// Writes one record with a single stream write
+template <typename Object>
+void write(const Object& object, std::ostream& out) {
+    thread_local BinaryWriter writer;
+    encode(object, writer);
+    writer.flushTo(out);
+}
+
+template <typename Object>
+void read(Object& object, std::istream& in) {
+    decode(object, in);
+}
+
+template <typename Class, typename Element>
+void ListField<Class, Element>::write(const Class& object, BinaryWriter& writer) const {
+    const std::vector<Element>& elements = object.*member;
+    size_t count = elements.size();
+    std::memcpy(writer.extend(sizeof(count)), &count, sizeof(count));
+    for (const auto& element : elements) encode(element, writer);
+}
+
+template <typename Class, typename Element>
+void ListField<Class, Element>::read(Class& object, std::istream& in) const {
+    std::vector<Element>& elements = object.*member;
+    size_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    elements.clear();
+    for (size_t i = 0; i < count && in; i++) {
+        Element element;
+        decode(element, in);
+        elements.push_back(element);
+    }
+}
+
+}  // namespace serialization
+
+#endif
@@ -0,0 +1,411 @@
+#include "sharded_bank.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <utility>
+
+// Shard implementation
+ShardedBank::Shard::Shard(ShardedBank* bank, size_t index, std::string fileName)
+    : bank(bank), index(index), fileName(fileName), dailyAmounts(QUANTILE_DAYS) {
+    loadData();
+}
+
+void ShardedBank::Shard::start() { worker = std::thread(&Shard::run, this); }
+
+void ShardedBank::Shard::post(Message message) {
+    {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        mailbox.push_back(std::move(message));
+    }
+    mailboxReady.notify_one();
+}
+
+void ShardedBank::Shard::join() {
+    if (worker.joinable()) worker.join();
+    saveData();
+}
+
+void ShardedBank::Shard::run() {
+    std::deque<Message> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mailboxMutex);
+            auto ready = [this] { return !mailbox.empty(); };
+            if (pendingTransfers.empty()) {
+                mailboxReady.wait(lock, ready);
+            } else {
+                // Wake up in time to resend credits whose outcome is overdue
+                std::chrono::steady_clock::duration timeout(bank->resendTimeout.load());
+                mailboxReady.wait_for(lock, timeout, ready);
+            }
+            batch.swap(mailbox);
+        }
+
+        // Everything below runs on the owner thread only, without locks
+        for (auto& message : batch) {
+            if (message.type == MessageType::STOP) return;
+            handle(message);
+        }
+        batch.clear();
+        resendExpiredCredits();
+    }
+}
+
+void ShardedBank::Shard::handle(Message& message) {
+    switch (message.type) {
+        case MessageType::ADD_CUSTOMER: {
+            const std::string& accountNumber = message.customer->getAccountNumber();
+            bool added = customers.find(accountNumber) == customers.end();
+            if (added) customers[accountNumber] = *message.customer;
+            message.reply->set_value(added);
+            bank->endRequest();
+            break;
+        }
+        case MessageType::BALANCE: {
+            auto it = customers.find(message.account);
+            double balance = it != customers.end() ? it->second.getBalance() : 0.0;
+            message.balanceReply->set_value(balance);
+            bank->endRequest();
+            break;
+        }
+        case MessageType::TRANSFER:
+            handleTransfer(message);
+            break;
+        case MessageType::CREDIT:
+            handleCredit(message);
+            break;
+        case MessageType::CREDIT_RESULT:
+            handleCreditResult(message);
+            break;
+        case MessageType::CREDIT_ACK:
+            handleCreditAck(message);
+            break;
+        case MessageType::STOP:
+            break;
+    }
+}
+
+void ShardedBank::Shard::handleTransfer(Message& message) {
+    const BankTransaction& transaction = *message.transaction;
+    auto sender = customers.find(transaction.getFromAccount());
+    double amount = transaction.getAmount();
+
+    if (sender == customers.end() || !sender->second.withdraw(amount)) {
+        message.reply->set_value(false);
+        bank->endRequest();
+        return;
+    }
+
+    size_t target = bank->shardOf(transaction.getToAccount());
+    if (target == index) {
+        auto receiver = customers.find(transaction.getToAccount());
+        bool success = receiver != customers.end();
+        if (success) {
+            receiver->second.deposit(amount);
+            ledger.push_back(transaction);
+            recordAmount(transaction);
+        } else {
+            sender->second.deposit(amount);
+        }
+        message.reply->set_value(success);
+        bank->endRequest();
+        return;
+    }
+
+    // Debit is applied; the transfer completes when the receiving shard answers
+    PendingTransfer& pending = pendingTransfers[message.transferId];
+    pending.transaction = message.transaction;
+    pending.reply = message.reply;
+    sendCredit(message.transferId, pending);
+}
+
+void ShardedBank::Shard::sendCredit(uint64_t transferId, PendingTransfer& pending) {
+    Message credit;
+    credit.type = MessageType::CREDIT;
+    credit.transferId = transferId;
+    credit.originShard = index;
+    credit.transaction = pending.transaction;
+    pending.sentAt = std::chrono::steady_clock::now();
+    bank->postCredit(bank->shardOf(pending.transaction->getToAccount()), std::move(credit));
+}
+
+// Sends the credits of pending transfers again once their outcome is overdue; the receiver
+// answers a repeated credit with its first outcome
+void ShardedBank::Shard::resendExpiredCredits() {
+    if (pendingTransfers.empty()) return;
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration timeout(bank->resendTimeout.load());
+    for (auto& pair : pendingTransfers) {
+        if (now - pair.second.sentAt < timeout) continue;
+        sendCredit(pair.first, pair.second);
+        bank->creditsResent.fetch_add(1);
+    }
+}
+
+void ShardedBank::Shard::handleCredit(Message& message) {
+    bool success = false;
+    auto answered = creditResults.find(message.transferId);
+    if (answered != creditResults.end()) {
+        success = answered->second;
+    } else {
+        auto receiver = customers.find(message.transaction->getToAccount());
+        success = receiver != customers.end();
+        if (success) {
+            receiver->second.deposit(message.transaction->getAmount());
+            ledger.push_back(*message.transaction);
+        }
+        creditResults[message.transferId] = success;
+    }
+
+    Message result;
+    result.type = MessageType::CREDIT_RESULT;
+    result.transferId = message.transferId;
+    result.success = success;
+    bank->shards[message.originShard]->post(std::move(result));
+}
+
+void ShardedBank::Shard::handleCreditResult(Message& message) {
+    auto it = pendingTransfers.find(message.transferId);
+    if (it == pendingTransfers.end()) return;  // duplicate answer
+
+    PendingTransfer pending = std::move(it->second);
+    pendingTransfers.erase(it);
+
+    // Counted as a request of its own and posted before the reply, so drain() also waits
+    // for the acknowledgement
+    Message ack;
+    ack.type = MessageType::CREDIT_ACK;
+    ack.transferId = message.transferId;
+    bank->beginRequest();
+    bank->shards[bank->shardOf(pending.transaction->getToAccount())]->post(std::move(ack));
+
+    if (message.success) {
+        ledger.push_back(*pending.transaction);
+        recordAmount(*pending.transaction);
+    } else {
+        // Compensate the debit
+        auto sender = customers.find(pending.transaction->getFromAccount());
+        if (sender != customers.end()) sender->second.deposit(pending.transaction->getAmount());
+    }
+    pending.reply->set_value(message.success);
+    bank->endRequest();
+}
+
+// The sender will not resend this transfer, so its id is no longer needed for deduplication
+void ShardedBank::Shard::handleCreditAck(Message& message) {
+    creditResults.erase(message.transferId);
+    bank->endRequest();
+}
+
+// Counted on the sending shard only; cross-shard transfers sit in both ledgers
+void ShardedBank::Shard::recordAmount(const BankTransaction& transaction) {
+    dailyAmounts.add(dayOf(transaction.getTimestamp()), transaction.getAmount());
+}
+
+// Removes and returns the customers whose account hashes to another shard, e.g. after the
+// shard count changed
+std::vector<BankCustomer> ShardedBank::Shard::takeMisplacedCustomers() {
+    std::vector<BankCustomer> misplaced;
+    for (auto it = customers.begin(); it != customers.end();) {
+        if (bank->shardOf(it->first) == index) {
+            ++it;
+            continue;
+        }
+        misplaced.push_back(it->second);
+        it = customers.erase(it);
+    }
+    return misplaced;
+}
+
+void ShardedBank::Shard::adoptCustomer(const BankCustomer& customer) {
+    customers.emplace(customer.getAccountNumber(), customer);
+}
+
+void ShardedBank::Shard::adoptLedger(const Shard& other) {
+    ledger.insert(ledger.end(), other.ledger.begin(), other.ledger.end());
+    dailyAmounts.merge(other.dailyAmounts);
+}
+
+void ShardedBank::Shard::loadData() {
+    if (fileName.empty()) return;
+    std::ifstream file(fileName, std::ios::binary);
+    if (file.is_open()) {
+        // Load customers
+        size_t customerCount;
+        file.read(reinterpret_cast<char*>(&customerCount), sizeof(customerCount));
+        for (size_t i = 0; i < customerCount && file; i++) {
+            BankCustomer customer;
+            customer.deserialize(file);
+            customers[customer.getAccountNumber()] = customer;
+        }
+
+        // Load ledger segment
+        size_t transactionCount;
+        file.read(reinterpret_cast<char*>(&transactionCount), sizeof(transactionCount));
+        for (size_t i = 0; i < transactionCount && file; i++) {
+            BankTransaction transaction;
+            transaction.deserialize(file);
+            ledger.push_back(transaction);
+            if (customers.count(transaction.getFromAccount())) recordAmount(transaction);
+        }
+
+        file.close();
+    }
+}
+
+void ShardedBank::Shard::saveData() const {
+    if (fileName.empty()) return;
+    std::ofstream file(fileName, std::ios::binary);
+    if (file.is_open()) {
+        // Save customers
+        size_t customerCount = customers.size();
+        file.write(reinterpret_cast<const char*>(&customerCount), sizeof(customerCount));
+        for (const auto& pair : customers) {
+            pair.second.serialize(file);
+        }
+
+        // Save ledger segment
+        size_t transactionCount = ledger.size();
+        file.write(reinterpret_cast<const char*>(&transactionCount), sizeof(transactionCount));
+        for (const auto& transaction : ledger) {
+            transaction.serialize(file);
+        }
+
+        file.close();
+    }
+}
+
+// ShardedBank implementation
+ShardedBank::ShardedBank(size_t shardCount, std::string filePrefix)
+    : nextTransferId(1),
+      resendTimeout(std::chrono::steady_clock::duration(DEFAULT_RESEND_TIMEOUT).count()),
+      creditDropInterval(0),
+      creditsSent(0),
+      creditsResent(0),
+      inFlight(0) {
+    if (shardCount == 0) shardCount = 1;
+    auto fileName = [&filePrefix](size_t i) {
+        return filePrefix.empty() ? "" : filePrefix + "_" + std::to_string(i) + ".bin";
+    };
+    for (size_t i = 0; i < shardCount; i++) {
+        shards.push_back(std::make_unique<Shard>(this, i, fileName(i)));
+    }
+
+    // Files of shards beyond the shard count (saved with more shards) are merged in and
+    // removed once the shards have saved; then every customer moves to its hash's shard
+    for (size_t i = shardCount; !filePrefix.empty(); i++) {
+        if (!std::ifstream(fileName(i)).is_open()) break;
+        Shard retired(this, i, fileName(i));
+        routeMisplacedCustomers(retired);
+        shards[i % shardCount]->adoptLedger(retired);
+        retiredFiles.push_back(fileName(i));
+    }
+    for (auto& shard : shards) routeMisplacedCustomers(*shard);
+
+    for (auto& shard : shards) shard->start();
+}
+
+ShardedBank::~ShardedBank() {
+    drain();
+    for (auto& shard : shards) {
+        Message stop;
+        stop.type = MessageType::STOP;
+        shard->post(std::move(stop));
+    }
+    for (auto& shard : shards) shard->join();
+    for (const auto& fileName : retiredFiles) std::remove(fileName.c_str());
+}
+
+void ShardedBank::routeMisplacedCustomers(Shard& from) {
+    for (const auto& customer : from.takeMisplacedCustomers()) {
+        shards[shardOf(customer.getAccountNumber())]->adoptCustomer(customer);
+    }
+}
+
+// Posts a credit to the receiving shard, unless fault injection loses it in transit
+void ShardedBank::postCredit(size_t target, Message message) {
+    size_t interval = creditDropInterval.load();
+    size_t sent = creditsSent.fetch_add(1) + 1;
+    if (interval > 0 && sent % interval == 0) return;
+    shards[target]->post(std::move(message));
+}
+
+size_t ShardedBank::shardOf(const std::string& accountNumber) const {
+    return std::hash<std::string>()(accountNumber) % shards.size();
+}
+
+void ShardedBank::beginRequest() { inFlight.fetch_add(1); }
+
+void ShardedBank::endRequest() {
+    if (inFlight.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drained.notify_all();
+    }
+}
+
+void ShardedBank::drain() {
+    std::unique_lock<std::mutex> lock(drainMutex);
+    drained.wait(lock, [this] { return inFlight.load() == 0; });
+}
+
+std::future<bool> ShardedBank::addCustomer(const BankCustomer& customer) {
+    Message message;
+    message.type = MessageType::ADD_CUSTOMER;
+    message.customer = std::make_shared<BankCustomer>(customer);
+    message.reply = std::make_shared<std::promise<bool>>();
+    auto result = message.reply->get_future();
+
+    beginRequest();
+    shards[shardOf(customer.getAccountNumber())]->post(std::move(message));
+    return result;
+}
+
+std::future<bool> ShardedBank::transfer(const BankTransaction& transaction) {
+    Message message;
+    message.type = MessageType::TRANSFER;
+    message.transferId = nextTransferId.fetch_add(1);
+    message.transaction = std::make_shared<BankTransaction>(transaction);
+    message.reply = std::make_shared<std::promise<bool>>();
+    auto result = message.reply->get_future();
+
+    beginRequest();
+    shards[shardOf(transaction.getFromAccount())]->post(std::move(message));
+    return result;
+}
+
+std::future<double> ShardedBank::getBalance(const std::string& accountNumber) {
+    Message message;
+    message.type = MessageType::BALANCE;
+    message.account = accountNumber;
+    message.balanceReply = std::make_shared<std::promise<double>>();
+    auto result = message.balanceReply->get_future();
+
+    beginRequest();
+    shards[shardOf(accountNumber)]->post(std::move(message));
+    return result;
+}
+
+size_t ShardedBank::getCustomerCount() const {
+    size_t total = 0;
+    for (const auto& shard : shards) total += shard->customerCount();
+    return total;
+}
+
+size_t ShardedBank::getLedgerSize() const {
+    size_t total = 0;
+    for (const auto& shard : shards) total += shard->ledgerSize();
+    return total;
+}
+
+size_t ShardedBank::getUnacknowledgedCredits() const {
+    size_t total = 0;
+    for (const auto& shard : shards) total += shard->unacknowledgedCredits();
+    return total;
+}
+
+KeyedQuantiles<int64_t> ShardedBank::getDailyAmountQuantiles() const {
+    KeyedQuantiles<int64_t> merged(QUANTILE_DAYS);
+    for (const auto& shard : shards) merged.merge(shard->getDailyAmounts());
+    return merged;
+}
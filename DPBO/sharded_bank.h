@@ -0,0 +1,169 @@
+#ifndef SHARDED_BANK_H
+#define SHARDED_BANK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bank_customer.h"
+#include "bank_transaction.h"
+#include "quantile_sketch.h"
+
+// Bank whose customers are partitioned by account-number hash into shards.
+// Each shard owns its customers, ledger segment and data file, and is only ever touched by
+// its own worker thread; other threads talk to it through its mailbox. Transfers within a
+// shard are applied directly. Transfers across shards debit the sender on its shard, then
+// send a credit message to the receiver's shard, which answers with the outcome; a rejected
+// credit refunds the sender. A credit unanswered for the resend timeout is sent again.
+// Credits are deduplicated by transfer id and answered with their first outcome, so a
+// redelivered message is applied exactly once. The sender acknowledges each outcome, after
+// which the receiver forgets the id: the sender only resends transfers still pending, and
+// a mailbox delivers one shard's messages in order, so no copy of the credit can follow the
+// acknowledgement. Pending transfers live in memory only; the destructor drains them and
+// their acknowledgements before the shards save, so a clean shutdown persists only settled
+// balances. Customers are routed by account hash again on load, so shard files saved
+// under another shard count are redistributed.
+// A prototype: the application still runs on Bank, and only "bench shards" uses this class.
+class ShardedBank {
+   private:
+    enum class MessageType {
+        ADD_CUSTOMER,
+        TRANSFER,
+        CREDIT,
+        CREDIT_RESULT,
+        CREDIT_ACK,
+        BALANCE,
+        STOP
+    };
+
+    struct Message {
+        MessageType type;
+        uint64_t transferId = 0;
+        size_t originShard = 0;
+        bool success = false;
+        std::string account;
+        std::shared_ptr<BankCustomer> customer;
+        std::shared_ptr<BankTransaction> transaction;
+        std::shared_ptr<std::promise<bool>> reply;
+        std::shared_ptr<std::promise<double>> balanceReply;
+    };
+
+    struct PendingTransfer {
+        std::shared_ptr<BankTransaction> transaction;
+        std::shared_ptr<std::promise<bool>> reply;
+        std::chrono::steady_clock::time_point sentAt;  // of the last credit sent
+    };
+
+    class Shard {
+       private:
+        ShardedBank* bank;
+        size_t index;
+        std::string fileName;
+        std::map<std::string, BankCustomer> customers;
+        std::vector<BankTransaction> ledger;
+        std::unordered_map<uint64_t, bool> creditResults;  // answered, not yet acknowledged
+        std::unordered_map<uint64_t, PendingTransfer> pendingTransfers;
+        KeyedQuantiles<int64_t> dailyAmounts;  // transfers sent from this shard, per day
+
+        std::mutex mailboxMutex;
+        std::condition_variable mailboxReady;
+        std::deque<Message> mailbox;
+        std::thread worker;
+
+        void run();
+        void handle(Message& message);
+        void handleTransfer(Message& message);
+        void handleCredit(Message& message);
+        void handleCreditResult(Message& message);
+        void handleCreditAck(Message& message);
+        void sendCredit(uint64_t transferId, PendingTransfer& pending);
+        void resendExpiredCredits();
+        void recordAmount(const BankTransaction& transaction);
+        void loadData();
+        void saveData() const;
+
+       public:
+        Shard(ShardedBank* bank, size_t index, std::string fileName);
+
+        void start();
+        void post(Message message);
+        void join();
+
+        // Loading only, before the workers start
+        std::vector<BankCustomer> takeMisplacedCustomers();
+        void adoptCustomer(const BankCustomer& customer);
+        void adoptLedger(const Shard& other);
+
+        size_t customerCount() const { return customers.size(); }
+        size_t ledgerSize() const { return ledger.size(); }
+        size_t unacknowledgedCredits() const { return creditResults.size(); }
+        const KeyedQuantiles<int64_t>& getDailyAmounts() const { return dailyAmounts; }
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::string> retiredFiles;  // files of shards beyond the shard count
+    std::atomic<uint64_t> nextTransferId;
+    std::atomic<std::chrono::steady_clock::rep> resendTimeout;
+    std::atomic<size_t> creditDropInterval;
+    std::atomic<size_t> creditsSent;
+    std::atomic<size_t> creditsResent;
+
+    // Requests whose reply has not been delivered yet
+    std::atomic<size_t> inFlight;
+    std::mutex drainMutex;
+    std::condition_variable drained;
+
+    void beginRequest();
+    void endRequest();
+    void routeMisplacedCustomers(Shard& from);
+    void postCredit(size_t target, Message message);
+
+   public:
+    static constexpr size_t QUANTILE_DAYS = 31;
+    static constexpr std::chrono::milliseconds DEFAULT_RESEND_TIMEOUT{100};
+
+    // An empty filePrefix keeps the shards in memory only
+    explicit ShardedBank(size_t shardCount, std::string filePrefix = "bank_shard");
+    ShardedBank(const ShardedBank&) = delete;
+    ShardedBank& operator=(const ShardedBank&) = delete;
+    ~ShardedBank();
+
+    size_t getShardCount() const { return shards.size(); }
+    size_t shardOf(const std::string& accountNumber) const;
+
+    std::future<bool> addCustomer(const BankCustomer& customer);
+    std::future<bool> transfer(const BankTransaction& transaction);
+    std::future<double> getBalance(const std::string& accountNumber);
+
+    // How long a shard waits for the outcome of a credit before sending it again
+    void setResendTimeout(std::chrono::steady_clock::duration timeout) {
+        resendTimeout.store(timeout.count());
+    }
+    // Fault injection for checks: every nth credit message (n >= 2) is lost in transit;
+    // 0 loses none
+    void setCreditDropInterval(size_t interval) { creditDropInterval.store(interval); }
+    size_t getResentCredits() const { return creditsResent.load(); }
+
+    // Blocks until every request submitted so far has completed
+    void drain();
+
+    // Totals across shards; only meaningful after drain()
+    size_t getCustomerCount() const;
+    size_t getLedgerSize() const;
+    // Credit ids kept for deduplication; zero after drain()
+    size_t getUnacknowledgedCredits() const;
+    // Per-day transfer amount quantiles, merged from the shards' sketches
+    KeyedQuantiles<int64_t> getDailyAmountQuantiles() const;
+};
+
+#endif
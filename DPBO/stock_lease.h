@@ -0,0 +1,63 @@
+#ifndef STOCK_LEASE_H
+#define STOCK_LEASE_H
+
+#include <algorithm>
+
+#include "item.h"
+
+// Told whenever a lease moves units in or out of an item's shared counter, so the owner of
+// the item (the Store) can re-file it in its indexes. Leases on one item may call it from
+// several threads at once.
+class StockListener {
+   public:
+    virtual ~StockListener() = default;
+    virtual void onStockChanged(const Item& item) = 0;
+};
+
+// Per-thread lease on the stock of a very hot item.
+// The lease reserves units from the item's shared counter a chunk at a time and hands them
+// out locally, so the shared word is touched once per chunk instead of once per purchase.
+// Leased units already count as sold; release() (or destruction) returns the unused ones.
+// Each chunk taken and each release is reported to the listener, if any.
+class StockLease {
+   private:
+    Item* item;
+    int chunkSize;
+    int available;
+    StockListener* listener;
+
+   public:
+    explicit StockLease(Item& item, int chunkSize = 32, StockListener* listener = nullptr)
+        : item(&item),
+          chunkSize(chunkSize > 0 ? chunkSize : 1),
+          available(0),
+          listener(listener) {}
+
+    StockLease(const StockLease&) = delete;
+    StockLease& operator=(const StockLease&) = delete;
+
+    ~StockLease() { release(); }
+
+    bool take(int amount = 1) {
+        if (available < amount) {
+            int taken = item->reserveUpTo(std::max(chunkSize, amount - available));
+            if (taken > 0 && listener) listener->onStockChanged(*item);
+            available += taken;
+            if (available < amount) return false;
+        }
+        available -= amount;
+        return true;
+    }
+
+    void release() {
+        if (available > 0) {
+            item->cancelSale(available);
+            available = 0;
+            if (listener) listener->onStockChanged(*item);
+        }
+    }
+
+    int getAvailable() const { return available; }
+};
+
+#endif
@@ -2,26 +2,178 @@
 #define STORE_H
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "buyer.h"
+#include "catalog_index.h"
+#include "clock.h"
+#include "heavy_hitters.h"
+#include "hyperloglog.h"
+#include "id_sequence.h"
 #include "item.h"
+#include "memory_usage.h"
+#include "order.h"
+#include "price_index.h"
+#include "quantile_sketch.h"
+#include "query_view.h"
+#include "sales_ranking.h"
 #include "seller.h"
+#include "stock_lease.h"
+#include "tiered_log.h"
 #include "transaction.h"
+#include "transaction_status_index.h"
 
-class Store {
+class Store : public PriceListener, public StockListener {
    private:
-    std::vector<Transaction> transactions;
+    std::string filePrefix;  // names the data and ledger files; empty keeps the store in memory
+    // Last HOT_DAYS in memory, older transactions in sealed segments on disk
+    TieredLog<Transaction, SealedTransactionCodec> transactions;
     std::map<int, Item> items;
     std::map<int, Buyer> buyers;
     std::map<int, Seller> sellers;
+    SalesRanking salesRanking;
+    CatalogIndex catalog;
+    PriceIndex priceIndex;
+    // Guards salesRanking and priceIndex, which StockLease threads re-file items in through
+    // onStockChanged, and price changes, which the price index reads. Every other reader and
+    // writer of them takes it too; a copy of the store gets a lock of its own.
+    struct IndexLock {
+        std::mutex mutex;
+        IndexLock() = default;
+        IndexLock(const IndexLock&) {}
+        IndexLock& operator=(const IndexLock&) { return *this; }
+    };
+    mutable IndexLock indexLock;
+    TransactionStatusIndex statusIndex;
+    std::unordered_map<int, size_t> transactionPositions;
+    std::vector<Order> orders;
+    std::unordered_map<int, size_t> orderPositions;
+    size_t orderLineCount = 0;  // in-memory transactions that belong to an order
+    // Sealed transactions per status, and sealed lines per order. Open (PENDING or PAID)
+    // transactions are sealed too once they leave the hot window; sealedOpen keeps their
+    // timestamps so status changes and status queries only read the segments from there.
+    std::array<size_t, 4> coldStatusCounts{};
+    std::unordered_map<int, size_t> sealedOrderLines;
+    std::unordered_map<int, std::chrono::system_clock::time_point> sealedOpen;
+    // Streaming quantiles of sale amounts: single-item transactions and whole orders
+    KeyedQuantiles<int64_t> dailyAmounts{QUANTILE_DAYS};
+    KeyedQuantiles<int> sellerAmounts;
+    // Distinct buyers of recorded sales, per seller, per item and per day
+    KeyedDistinctCounts<int> sellerBuyers;
+    KeyedDistinctCounts<int> itemBuyers;
+    KeyedDistinctCounts<int64_t> dailyBuyers{DISTINCT_DAYS};
+    HeavyHitters trendingItems;  // units sold per item over the last 24 hours
+    IdSequence ids;
+    const Clock* clock = &SystemClock::instance();
+
+    void recordTransaction(const Transaction& transaction) {
+        ids.observe(SequenceKind::TRANSACTION, transaction.getId());
+        transactionPositions[transaction.getId()] = transactions.size();
+        transactions.push_back(transaction);
+        statusIndex.add(transaction.getStatus());
+        if (transaction.getStatus() != TransactionStatus::CANCELED) {
+            sellerBuyers.add(transaction.getSellerId(), transaction.getBuyerId());
+            itemBuyers.add(transaction.getItemId(), transaction.getBuyerId());
+            dailyBuyers.add(dayOf(transaction.getTimestamp()), transaction.getBuyerId());
+            trendingItems.add(transaction.getItemId(), transaction.getTimestamp(),
+                              transaction.getQuantity());
+        }
+        if (!transaction.isOrderLine()) {
+            recordAmount(transaction.getTimestamp(), transaction.getSellerId(),
+                         transaction.getAmount());
+        }
+    }
+
+    void recordAmount(std::chrono::system_clock::time_point time, int sellerId, double amount) {
+        dailyAmounts.add(dayOf(time), amount);
+        sellerAmounts.add(sellerId, amount);
+    }
+
+    // Keeps the order as one record and expands its lines into the transaction list,
+    // skipping the leading lines already sealed to disk
+    void recordOrder(const Order& order) {
+        ids.observe(SequenceKind::ORDER, order.getId());
+        orderPositions[order.getId()] = orders.size();
+        orders.push_back(order);
+        auto sealed = sealedOrderLines.find(order.getId());
+        size_t first = sealed != sealedOrderLines.end() ? sealed->second : 0;
+        for (size_t i = first; i < order.getLines().size(); i++) {
+            recordTransaction(order.lineTransaction(i));
+            orderLineCount++;
+        }
+        recordAmount(order.getTimestamp(), order.getSellerId(), order.getTotal());
+    }
+
+    // Re-files an item in the secondary indexes after its stock or price changed
+    void refreshItemIndexes(const Item& item) {
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        salesRanking.update(item);
+        priceIndex.update(item);
+    }
+
+    void setTransactionStatus(size_t position, TransactionStatus status) {
+        transactions[position].setStatus(status);
+        statusIndex.setStatus(position, status);
+    }
+
+    static bool isFinal(TransactionStatus status) {
+        return status == TransactionStatus::COMPLETED || status == TransactionStatus::CANCELED;
+    }
+
+    // Sets the status of the sealed transactions from `from` onwards that match, rewriting
+    // their segments; returns how many were updated
+    template <typename Match>
+    size_t updateSealedStatus(std::chrono::system_clock::time_point from, Match match,
+                              TransactionStatus status) {
+        return transactions.updateColdSince(
+            from,
+            [&match, status](Transaction& t) {
+                if (!match(t)) return false;
+                t.setStatus(status);
+                return true;
+            },
+            [this](const Transaction& before, const Transaction& after) {
+                coldStatusCounts[static_cast<size_t>(before.getStatus())]--;
+                coldStatusCounts[static_cast<size_t>(after.getStatus())]++;
+                if (isFinal(after.getStatus())) {
+                    sealedOpen.erase(after.getId());
+                } else {
+                    sealedOpen[after.getId()] = after.getTimestamp();
+                }
+                if (Buyer* buyer = findBuyer(after.getBuyerId())) {
+                    buyer->updateTransactionStatus(after.getId(), after.getStatus());
+                }
+                if (Seller* seller = findSeller(after.getSellerId())) {
+                    seller->updateTransactionStatus(after.getId(), after.getStatus());
+                }
+            });
+    }
+
+    // Order whose block of line transaction ids holds transactionId
+    const Order* findOrderOfLine(int transactionId) const {
+        for (const auto& order : orders) {
+            int first = order.getFirstTransactionId();
+            if (transactionId >= first &&
+                transactionId < first + static_cast<int>(order.getLines().size())) {
+                return &order;
+            }
+        }
+        return nullptr;
+    }
 
     void loadData() {
-        std::ifstream file("store_data.bin", std::ios::binary);
+        if (filePrefix.empty()) return;
+        std::ifstream file(filePrefix + "_data.bin", std::ios::binary);
         if (file.is_open()) {
             // Load items
             size_t itemCount;
@@ -30,23 +182,137 @@ class Store {
                 Item item;
                 item.deserialize(file);
                 items[item.getId()] = item;
+                salesRanking.insert(items[item.getId()]);
+                priceIndex.insert(items[item.getId()]);
+                catalog.add(item.getId(), item.getName());
+                ids.observe(SequenceKind::ITEM, item.getId());
             }
 
-            // Load transactions
+            // Load the in-memory transactions; they are recorded once the segment directory
+            // at the end of the file has placed them after the sealed ones
             size_t transactionCount;
             file.read(reinterpret_cast<char*>(&transactionCount), sizeof(transactionCount));
-            for (size_t i = 0; i < transactionCount; i++) {
-                Transaction transaction;
-                transaction.deserialize(file);
-                transactions.push_back(transaction);
+            std::vector<Transaction> hot(transactionCount);
+            for (auto& transaction : hot) transaction.deserialize(file);
+
+            // Load id high-water marks (absent in older files)
+            ids.deserialize(file);
+
+            // Load orders, one record per order (absent in older files)
+            std::vector<Order> loadedOrders;
+            size_t orderCount = 0;
+            if (file.read(reinterpret_cast<char*>(&orderCount), sizeof(orderCount))) {
+                for (size_t i = 0; i < orderCount; i++) {
+                    Order order;
+                    if (!order.deserialize(file)) break;
+                    loadedOrders.push_back(order);
+                }
+            }
+
+            // Merge the saved distinct-buyer counters (absent in older files); they also
+            // cover transactions no longer in the log. The amount sketches saved after the
+            // cold state replace the ones replayed from the in-memory log below.
+            KeyedQuantiles<int64_t> savedDailyAmounts{QUANTILE_DAYS};
+            KeyedQuantiles<int> savedSellerAmounts;
+            bool amountsSaved = false;
+            if (sellerBuyers.deserialize(file) && itemBuyers.deserialize(file) &&
+                dailyBuyers.deserialize(file) && loadColdState(file)) {
+                amountsSaved = savedDailyAmounts.deserialize(file) &&
+                               savedSellerAmounts.deserialize(file);
+            }
+
+            // Quantities of the in-memory single transactions of more than one unit, in
+            // their order (absent in older files, whose single transactions are all one unit)
+            size_t multiUnitCount = 0;
+            if (amountsSaved &&
+                file.read(reinterpret_cast<char*>(&multiUnitCount), sizeof(multiUnitCount))) {
+                for (size_t i = 0; i < multiUnitCount; i++) {
+                    int entry[2] = {0, 1};  // position in hot, quantity
+                    if (!file.read(reinterpret_cast<char*>(entry), sizeof(entry))) break;
+                    if (entry[0] >= 0 && static_cast<size_t>(entry[0]) < hot.size()) {
+                        hot[entry[0]].setQuantity(entry[1]);
+                    }
+                }
             }
 
+            // Sealed open transactions (absent in older files, which only sealed final ones)
+            size_t sealedOpenCount = 0;
+            if (amountsSaved &&
+                file.read(reinterpret_cast<char*>(&sealedOpenCount), sizeof(sealedOpenCount))) {
+                for (size_t i = 0; i < sealedOpenCount; i++) {
+                    int transactionId = 0;
+                    std::chrono::system_clock::duration::rep ticks = 0;
+                    file.read(reinterpret_cast<char*>(&transactionId), sizeof(transactionId));
+                    if (!file.read(reinterpret_cast<char*>(&ticks), sizeof(ticks))) break;
+                    sealedOpen[transactionId] = std::chrono::system_clock::time_point(
+                        std::chrono::system_clock::duration(ticks));
+                }
+            }
             file.close();
+
+            // Single transactions and orders are saved apart; replay them in time order
+            // (an order's lines at the order's time) so the log stays in time order
+            std::vector<std::pair<std::chrono::system_clock::time_point, size_t>> replay;
+            for (size_t i = 0; i < hot.size(); i++) replay.emplace_back(hot[i].getTimestamp(), i);
+            for (size_t i = 0; i < loadedOrders.size(); i++) {
+                replay.emplace_back(loadedOrders[i].getTimestamp(), hot.size() + i);
+            }
+            std::stable_sort(replay.begin(), replay.end(), [](const auto& a, const auto& b) {
+                return a.first < b.first;
+            });
+
+            statusIndex.clear(transactions.getHotBase());
+            for (const auto& entry : replay) {
+                if (entry.second < hot.size()) {
+                    recordTransaction(hot[entry.second]);
+                } else {
+                    recordOrder(loadedOrders[entry.second - hot.size()]);
+                }
+            }
+            if (amountsSaved) {
+                dailyAmounts = std::move(savedDailyAmounts);
+                sellerAmounts = std::move(savedSellerAmounts);
+            }
+        }
+    }
+
+    // Segment directory, sealed status counts and sealed order lines (absent in older
+    // files); false when the block is missing or cut short
+    bool loadColdState(std::ifstream& file) {
+        if (!transactions.deserializeDirectory(file)) return false;
+        file.read(reinterpret_cast<char*>(coldStatusCounts.data()), sizeof(coldStatusCounts));
+        size_t sealedOrderCount = 0;
+        file.read(reinterpret_cast<char*>(&sealedOrderCount), sizeof(sealedOrderCount));
+        for (size_t i = 0; i < sealedOrderCount && file; i++) {
+            int orderId = 0;
+            size_t lines = 0;
+            file.read(reinterpret_cast<char*>(&orderId), sizeof(orderId));
+            file.read(reinterpret_cast<char*>(&lines), sizeof(lines));
+            if (file) sealedOrderLines[orderId] = lines;
+        }
+        return static_cast<bool>(file);
+    }
+
+    // Oldest sealed open transaction, the earliest segment an open status can be found in
+    std::chrono::system_clock::time_point oldestSealedOpen() const {
+        auto oldest = std::chrono::system_clock::time_point::max();
+        for (const auto& pair : sealedOpen) oldest = std::min(oldest, pair.second);
+        return oldest;
+    }
+
+    // Seals once the oldest in-memory transaction is a day past the hot window, so segments
+    // are written in day-sized batches
+    void sealIfDue() {
+        const auto& hot = transactions.getHot();
+        if (!hot.empty() &&
+            hot.front().getTimestamp() < clock->now() - std::chrono::hours((HOT_DAYS + 1) * 24)) {
+            sealColdTransactions();
         }
     }
 
     void saveData() const {
-        std::ofstream file("store_data.bin", std::ios::binary);
+        if (filePrefix.empty()) return;
+        std::ofstream file(filePrefix + "_data.bin", std::ios::binary);
         if (file.is_open()) {
             // Save items
             size_t itemCount = items.size();
@@ -55,11 +321,66 @@ class Store {
                 pair.second.serialize(file);
             }
 
-            // Save transactions
-            size_t transactionCount = transactions.size();
+            // Save the in-memory transactions; order lines are saved with their order
+            size_t transactionCount = transactions.getHot().size() - orderLineCount;
             file.write(reinterpret_cast<const char*>(&transactionCount), sizeof(transactionCount));
-            for (const auto& transaction : transactions) {
-                transaction.serialize(file);
+            for (const auto& transaction : transactions.getHot()) {
+                if (!transaction.isOrderLine()) transaction.serialize(file);
+            }
+
+            // Save id high-water marks
+            ids.serialize(file);
+
+            // Save orders
+            size_t orderCount = orders.size();
+            file.write(reinterpret_cast<const char*>(&orderCount), sizeof(orderCount));
+            for (const auto& order : orders) {
+                order.serialize(file);
+            }
+
+            // Save distinct-buyer counters
+            sellerBuyers.serialize(file);
+            itemBuyers.serialize(file);
+            dailyBuyers.serialize(file);
+
+            // Save the segment directory and what the store keeps about sealed transactions
+            transactions.serializeDirectory(file);
+            file.write(reinterpret_cast<const char*>(coldStatusCounts.data()),
+                       sizeof(coldStatusCounts));
+            size_t sealedOrderCount = sealedOrderLines.size();
+            file.write(reinterpret_cast<const char*>(&sealedOrderCount), sizeof(sealedOrderCount));
+            for (const auto& pair : sealedOrderLines) {
+                file.write(reinterpret_cast<const char*>(&pair.first), sizeof(pair.first));
+                file.write(reinterpret_cast<const char*>(&pair.second), sizeof(pair.second));
+            }
+
+            // Save the amount sketches, which also cover sealed transactions
+            dailyAmounts.serialize(file);
+            sellerAmounts.serialize(file);
+
+            // Save the quantities the single transaction records leave out, by position
+            // among the saved single transactions
+            std::vector<std::array<int, 2>> multiUnit;
+            int position = 0;
+            for (const auto& transaction : transactions.getHot()) {
+                if (transaction.isOrderLine()) continue;
+                if (transaction.getQuantity() != 1) {
+                    multiUnit.push_back({position, transaction.getQuantity()});
+                }
+                position++;
+            }
+            size_t multiUnitCount = multiUnit.size();
+            file.write(reinterpret_cast<const char*>(&multiUnitCount), sizeof(multiUnitCount));
+            file.write(reinterpret_cast<const char*>(multiUnit.data()),
+                       multiUnit.size() * sizeof(std::array<int, 2>));
+
+            // Save the ids and timestamps of the sealed open transactions
+            size_t sealedOpenCount = sealedOpen.size();
+            file.write(reinterpret_cast<const char*>(&sealedOpenCount), sizeof(sealedOpenCount));
+            for (const auto& pair : sealedOpen) {
+                file.write(reinterpret_cast<const char*>(&pair.first), sizeof(pair.first));
+                auto ticks = pair.second.time_since_epoch().count();
+                file.write(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
             }
 
             file.close();
@@ -67,40 +388,168 @@ class Store {
     }
 
    public:
-    Store() { loadData(); }
+    static constexpr size_t QUANTILE_DAYS = 31;
+    static constexpr size_t DISTINCT_DAYS = 366;
+    static constexpr int HOT_DAYS = 31;
+
+    Store() : Store("store") {}
 
-    ~Store() { saveData(); }
+    // A store persisted under filePrefix; an empty prefix keeps it in memory only
+    explicit Store(std::string filePrefix)
+        : filePrefix(std::move(filePrefix)),
+          transactions(this->filePrefix.empty() ? "" : this->filePrefix + "_ledger") {
+        loadData();
+        sealColdTransactions();
+    }
+
+    ~Store() {
+        sealColdTransactions();
+        saveData();
+    }
+
+    // Moves transactions older than HOT_DAYS to disk; also runs as the log grows. A stale
+    // open (PENDING or PAID) transaction is sealed like any other and noted in sealedOpen,
+    // so it can neither hold back sealing nor lose its later status changes.
+    void sealColdTransactions() {
+        auto cutoff = clock->now() - std::chrono::hours(HOT_DAYS * 24);
+        size_t sealed = transactions.sealBefore(
+            cutoff, [](const Transaction&) { return true; },
+            [this](size_t, const Transaction& t) {
+                transactionPositions.erase(t.getId());
+                coldStatusCounts[static_cast<size_t>(t.getStatus())]++;
+                if (!isFinal(t.getStatus())) sealedOpen[t.getId()] = t.getTimestamp();
+                if (t.isOrderLine()) {
+                    sealedOrderLines[t.getOrderId()]++;
+                    orderLineCount--;
+                }
+            });
+        statusIndex.dropFront(sealed);
+    }
+
+    // Time source for all time-window queries; the clock must outlive the store
+    void setClock(const Clock& clock) { this->clock = &clock; }
+    const Clock& getClock() const { return *clock; }
+
+    // Id allocation
+    int nextItemId() { return ids.next(SequenceKind::ITEM); }
+    int nextTransactionId() { return ids.next(SequenceKind::TRANSACTION); }
+    int nextOrderId() { return ids.next(SequenceKind::ORDER); }
+    IdSequence& getIdSequence() { return ids; }
+
+    // Lazy views over internal storage; records are only copied on toVector()
+    auto itemsView() const {
+        return makeQueryView(items.begin(), items.end(), MappedValueProjection());
+    }
+
+    // Views cover the in-memory transactions: at least the last HOT_DAYS
+    auto transactionsView() const {
+        return makeQueryView(transactions.hotBegin(), transactions.hotEnd());
+    }
+
+    // Items priced within [minPrice, maxPrice] in (price, id) order, resuming after cursor.
+    // The view reads the price index unlocked, so it must not overlap stock leases; use
+    // browseByPrice() while leases are active.
+    auto itemsByPriceView(double minPrice, double maxPrice, bool inStockOnly,
+                          const PriceCursor& after = PriceCursor()) const {
+        auto bounds = priceIndex.range(minPrice, maxPrice, inStockOnly, after);
+        return makeQueryView(bounds.first, bounds.second, PriceEntryProjection{&items});
+    }
+
+    auto transactionsInLastDaysView(int days) const {
+        auto now = clock->now();
+        return transactionsView().where(
+            [days, now](const Transaction& t) { return t.isWithinDays(days, now); });
+    }
+
+    auto transactionsByStatusView(TransactionStatus status) const {
+        return makeQueryView(statusIndex.begin(status), statusIndex.end(),
+                             PositionProjection<decltype(transactions)>{&transactions});
+    }
+
+    auto pendingTransactionsView() const {
+        return transactionsByStatusView(TransactionStatus::PAID);
+    }
 
     // Transaction management
+    // Reads sealed segments from disk when days reaches past the hot window
     std::vector<Transaction> getTransactionsInLastDays(int days) const {
+        if (days <= HOT_DAYS) return transactionsInLastDaysView(days).toVector();
+        auto now = clock->now();
         std::vector<Transaction> recent;
-        auto now = std::chrono::system_clock::now();
-
-        std::copy_if(transactions.begin(), transactions.end(), std::back_inserter(recent),
-                     [days](const Transaction& t) { return t.isWithinDays(days); });
+        transactions.forEachSince(now - std::chrono::hours((days + 1) * 24),
+                                  [&recent, days, now](const Transaction& t) {
+                                      if (t.isWithinDays(days, now)) recent.push_back(t);
+                                  });
         return recent;
     }
 
     std::vector<Transaction> getPendingTransactions() const {
-        std::vector<Transaction> pending;
-        std::copy_if(transactions.begin(), transactions.end(), std::back_inserter(pending),
-                     [](const Transaction& t) { return t.getStatus() == TransactionStatus::PAID; });
-        return pending;
+        return getTransactionsByStatus(TransactionStatus::PAID);
     }
 
-    std::vector<Item> getMostSoldItems(int count) const {
-        std::vector<Item> sortedItems;
-        for (const auto& pair : items) {
-            sortedItems.push_back(pair.second);
+    // Sealed transactions first, read from disk, then the in-memory ones. Open statuses
+    // only read the segments from the oldest sealed open transaction on.
+    std::vector<Transaction> getTransactionsByStatus(TransactionStatus status) const {
+        std::vector<Transaction> result;
+        if (coldStatusCounts[static_cast<size_t>(status)] > 0) {
+            transactions.forEachColdSince(
+                isFinal(status) ? std::chrono::system_clock::time_point::min()
+                                : oldestSealedOpen(),
+                [&result, status](const Transaction& t) {
+                    if (t.getStatus() == status) result.push_back(t);
+                });
+        }
+        for (const auto& transaction : transactionsByStatusView(status)) {
+            result.push_back(transaction);
         }
+        return result;
+    }
 
-        std::sort(sortedItems.begin(), sortedItems.end(),
-                  [](const Item& a, const Item& b) { return a.getSoldCount() > b.getSoldCount(); });
+    size_t countTransactionsByStatus(TransactionStatus status) const {
+        return statusIndex.count(status) + coldStatusCounts[static_cast<size_t>(status)];
+    }
 
-        if (sortedItems.size() > count) {
-            sortedItems.resize(count);
+    // A line of an order changes status together with the rest of its order. Sealed
+    // transactions are rewritten in their segment, found from sealedOpen when still open.
+    bool updateTransactionStatus(int transactionId, TransactionStatus status) {
+        auto it = transactionPositions.find(transactionId);
+        if (it == transactionPositions.end()) {
+            if (const Order* order = findOrderOfLine(transactionId)) {
+                return updateOrderStatus(order->getId(), status);
+            }
+            auto matches = [transactionId](const Transaction& t) {
+                return t.getId() == transactionId;
+            };
+            auto open = sealedOpen.find(transactionId);
+            auto from = open != sealedOpen.end() ? open->second
+                                                 : std::chrono::system_clock::time_point::min();
+            return updateSealedStatus(from, matches, status) > 0;
         }
-        return sortedItems;
+        const Transaction& transaction = transactions[it->second];
+        if (transaction.isOrderLine()) return updateOrderStatus(transaction.getOrderId(), status);
+        setTransactionStatus(it->second, status);
+        if (Buyer* buyer = findBuyer(transaction.getBuyerId())) {
+            buyer->updateTransactionStatus(transactionId, status);
+        }
+        if (Seller* seller = findSeller(transaction.getSellerId())) {
+            seller->updateTransactionStatus(transactionId, status);
+        }
+        return true;
+    }
+
+    std::vector<Item> getMostSoldItems(int count) const {
+        std::vector<Item> topItems;
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        for (int itemId : salesRanking.top(count)) {
+            topItems.push_back(items.at(itemId));
+        }
+        return topItems;
+    }
+
+    // 1-based best-seller position of an item, 0 if the item is unknown
+    int getItemRank(int itemId) const {
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        return salesRanking.rankOf(itemId);
     }
 
     std::pair<Buyer*, Seller*> getMostActiveUsersToday() {
@@ -109,10 +558,10 @@ class Store {
         int maxBuyerCount = 0;
         int maxSellerCount = 0;
 
-        auto now = std::chrono::system_clock::now();
+        auto now = clock->now();
 
         for (auto& pair : buyers) {
-            int count = countTodayTransactions(pair.second.getId(), true);
+            int count = countTodayTransactions(pair.second.getId(), true, now);
             if (count > maxBuyerCount) {
                 maxBuyerCount = count;
                 topBuyer = &pair.second;
@@ -120,7 +569,7 @@ class Store {
         }
 
         for (auto& pair : sellers) {
-            int count = countTodayTransactions(pair.second.getId(), false);
+            int count = countTodayTransactions(pair.second.getId(), false, now);
             if (count > maxSellerCount) {
                 maxSellerCount = count;
                 topSeller = &pair.second;
@@ -130,17 +579,147 @@ class Store {
         return {topBuyer, topSeller};
     }
 
+    // Records a one-unit purchase and passes it to the buyer and seller when they are
+    // registered with the store, so later status changes reach their indexes and stats
     bool processTransaction(Transaction& transaction) {
         if (transaction.getStatus() == TransactionStatus::PENDING) {
             Item* item = findItem(transaction.getItemId());
             if (item && item->decreaseStock(1)) {
-                transactions.push_back(transaction);
+                refreshItemIndexes(*item);
+                recordTransaction(transaction);
+                if (Buyer* buyer = findBuyer(transaction.getBuyerId())) {
+                    buyer->addTransaction(transaction);
+                }
+                if (Seller* seller = findSeller(transaction.getSellerId())) {
+                    seller->addTransaction(transaction);
+                }
+                sealIfDue();
                 return true;
             }
         }
         return false;
     }
 
+    // Commits a multi-line order as one unit. The lines are sorted by item id, then
+    // validated and their stock taken in a single pass; if any line cannot be filled, the
+    // stock already taken is given back and nothing is recorded. On success the order gets
+    // one block of transaction ids, is logged as one record, and its per-line transactions
+    // are passed to the buyer and seller when they are registered with the store.
+    bool processOrder(Order& order) {
+        if (order.getStatus() != TransactionStatus::PENDING || order.getLines().empty()) {
+            return false;
+        }
+        order.normalize();
+
+        const std::vector<OrderLine>& lines = order.getLines();
+        std::vector<Item*> lineItems;
+        lineItems.reserve(lines.size());
+        for (size_t i = 0; i < lines.size(); i++) {
+            Item* item = findItem(lines[i].itemId);
+            if (!item || !item->decreaseStock(lines[i].quantity)) {
+                for (size_t j = 0; j < i; j++) lineItems[j]->cancelSale(lines[j].quantity);
+                return false;
+            }
+            order.setUnitPrice(i, item->getPrice());
+            lineItems.push_back(item);
+        }
+        for (Item* item : lineItems) refreshItemIndexes(*item);
+
+        order.setFirstTransactionId(
+            ids.reserve(SequenceKind::TRANSACTION, static_cast<int>(lines.size())));
+        recordOrder(order);
+
+        Buyer* buyer = findBuyer(order.getBuyerId());
+        Seller* seller = findSeller(order.getSellerId());
+        for (size_t i = 0; (buyer || seller) && i < lines.size(); i++) {
+            Transaction transaction = order.lineTransaction(i);
+            if (buyer) buyer->addTransaction(transaction);
+            if (seller) seller->addTransaction(transaction);
+        }
+        sealIfDue();
+        return true;
+    }
+
+    // Sealed lines of the order are rewritten in their segments
+    bool updateOrderStatus(int orderId, TransactionStatus status) {
+        auto it = orderPositions.find(orderId);
+        if (it == orderPositions.end()) return false;
+        Order& order = orders[it->second];
+        auto sealed = sealedOrderLines.find(orderId);
+        size_t sealedLines = sealed != sealedOrderLines.end() ? sealed->second : 0;
+        if (sealedLines > 0) {
+            auto matches = [orderId](const Transaction& t) { return t.getOrderId() == orderId; };
+            if (updateSealedStatus(order.getTimestamp(), matches, status) < sealedLines) {
+                return false;
+            }
+        }
+        order.setStatus(status);
+
+        Buyer* buyer = findBuyer(order.getBuyerId());
+        Seller* seller = findSeller(order.getSellerId());
+        for (size_t i = sealedLines; i < order.getLines().size(); i++) {
+            int transactionId = order.getFirstTransactionId() + static_cast<int>(i);
+            setTransactionStatus(transactionPositions.at(transactionId), status);
+            if (buyer) buyer->updateTransactionStatus(transactionId, status);
+            if (seller) seller->updateTransactionStatus(transactionId, status);
+        }
+        return true;
+    }
+
+    const Order* findOrder(int orderId) const {
+        auto it = orderPositions.find(orderId);
+        return it != orderPositions.end() ? &orders[it->second] : nullptr;
+    }
+
+    size_t getOrderCount() const { return orders.size(); }
+
+    // Stock reservation for multi-step checkouts: reserve, then commit or release
+    bool reserveStock(int itemId, int quantity) {
+        Item* item = findItem(itemId);
+        if (item && quantity > 0 && item->decreaseStock(quantity)) {
+            refreshItemIndexes(*item);
+            return true;
+        }
+        return false;
+    }
+
+    void releaseStock(int itemId, int quantity) {
+        Item* item = findItem(itemId);
+        if (item) {
+            item->cancelSale(quantity);
+            refreshItemIndexes(*item);
+        }
+    }
+
+    // Records a transaction whose stock was already reserved
+    void commitTransaction(const Transaction& transaction) {
+        recordTransaction(transaction);
+        sealIfDue();
+    }
+
+    // User management
+    bool addBuyer(const Buyer& buyer) { return buyers.emplace(buyer.getId(), buyer).second; }
+
+    Buyer* findBuyer(int buyerId) {
+        auto it = buyers.find(buyerId);
+        return it != buyers.end() ? &(it->second) : nullptr;
+    }
+
+    bool addSeller(const Seller& seller) {
+        auto result = sellers.emplace(seller.getId(), seller);
+        if (result.second) result.first->second.setPriceListener(this);
+        return result.second;
+    }
+
+    // Sellers are (re)attached on every lookup, so their price changes reach this store
+    // even after the store was copied
+    Seller* findSeller(int sellerId) {
+        auto it = sellers.find(sellerId);
+        if (it == sellers.end()) return nullptr;
+        it->second.setPriceListener(this);
+        return &(it->second);
+    }
+
     // Item management
     Item* findItem(int itemId) {
         auto it = items.find(itemId);
@@ -150,16 +729,241 @@ class Store {
     bool addItem(const Item& item) {
         if (items.find(item.getId()) == items.end()) {
             items[item.getId()] = item;
+            {
+                std::lock_guard<std::mutex> lock(indexLock.mutex);
+                salesRanking.insert(items[item.getId()]);
+                priceIndex.insert(items[item.getId()]);
+            }
+            catalog.add(item.getId(), item.getName());
+            ids.observe(SequenceKind::ITEM, item.getId());
             return true;
         }
         return false;
     }
 
+    bool setItemPrice(int itemId, double price) {
+        Item* item = findItem(itemId);
+        if (!item || price < 0) return false;
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        item->setPrice(price);
+        priceIndex.update(*item);
+        return true;
+    }
+
+    // Bulk repricing; returns how many of the (itemId, price) pairs were applied
+    size_t repriceItems(const std::vector<std::pair<int, double>>& prices) {
+        size_t applied = 0;
+        for (const auto& pair : prices) {
+            if (setItemPrice(pair.first, pair.second)) applied++;
+        }
+        return applied;
+    }
+
+    bool restockItem(int itemId, int quantity) {
+        Item* item = findItem(itemId);
+        if (!item || quantity <= 0) return false;
+        item->increaseStock(quantity, clock->now());
+        refreshItemIndexes(*item);
+        return true;
+    }
+
+    void onPriceChanged(int itemId, double price) override { setItemPrice(itemId, price); }
+
+    // Stock moved by a StockLease (see leaseStock); leases may call it from several threads
+    void onStockChanged(const Item& item) override { refreshItemIndexes(item); }
+
+    // A lease on an item's stock whose chunks and releases keep this store's sales ranking
+    // and price index current; null for an unknown item
+    std::unique_ptr<StockLease> leaseStock(int itemId, int chunkSize = 32) {
+        Item* item = findItem(itemId);
+        return item ? std::make_unique<StockLease>(*item, chunkSize, this) : nullptr;
+    }
+
+    // One page of a price-ordered listing; cursor is advanced past the returned items
+    std::vector<const Item*> browseByPrice(double minPrice, double maxPrice, bool inStockOnly,
+                                           size_t pageSize, PriceCursor& cursor) const {
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        std::vector<const Item*> page =
+            itemsByPriceView(minPrice, maxPrice, inStockOnly, cursor).limit(pageSize).toPointers();
+        if (!page.empty()) cursor = {page.back()->getPrice(), page.back()->getId()};
+        return page;
+    }
+
+    size_t countItemsInPriceRange(double minPrice, double maxPrice, bool inStockOnly) const {
+        std::lock_guard<std::mutex> lock(indexLock.mutex);
+        return priceIndex.countInRange(minPrice, maxPrice, inStockOnly);
+    }
+
+    // Renames the item in the catalog and in every registered seller's listing
+    bool renameItem(int itemId, const std::string& name) {
+        Item* item = findItem(itemId);
+        if (!item || name.empty()) return false;
+        item->setName(name);
+        catalog.rename(itemId, name);
+        for (auto& pair : sellers) pair.second.renameItem(itemId, name);
+        return true;
+    }
+
+    // Catalog search; every query returns handles to the limit best sellers among all
+    // matching items, best first
+    std::vector<const Item*> searchItems(const std::string& text, size_t limit = 20) const {
+        return topSellers(
+            [this, &text](auto visit) { catalog.forEachSubstringMatch(text, visit); }, limit);
+    }
+
+    std::vector<const Item*> autocompleteItems(const std::string& prefix,
+                                               size_t limit = 10) const {
+        return topSellers(
+            [this, &prefix](auto visit) { catalog.forEachPrefixMatch(prefix, visit); }, limit);
+    }
+
+    // Closest names first (most shared trigrams), then best sellers
+    std::vector<const Item*> fuzzySearchItems(const std::string& text, size_t limit = 20) const {
+        std::vector<std::pair<int, int>> matches = catalog.fuzzyMatches(text);
+        auto closer = [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+            if (a.second != b.second) return a.second > b.second;
+            return isBetterSeller(a.first, b.first);
+        };
+        size_t count = std::min(limit, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), closer);
+
+        std::vector<const Item*> result;
+        for (size_t i = 0; i < count; i++) result.push_back(&items.at(matches[i].first));
+        return result;
+    }
+
+    const KeyedQuantiles<int64_t>& getDailyAmountQuantiles() const { return dailyAmounts; }
+    const KeyedQuantiles<int>& getSellerAmountQuantiles() const { return sellerAmounts; }
+
+    // Estimated distinct buyers (about 1% error), each in O(1) from a HyperLogLog
+    double countDistinctBuyersOfSeller(int sellerId) const {
+        return sellerBuyers.estimate(sellerId);
+    }
+    double countDistinctBuyersOfItem(int itemId) const { return itemBuyers.estimate(itemId); }
+    double countDistinctBuyersOnDay(int64_t day) const { return dailyBuyers.estimate(day); }
+
+    // Distinct buyers over the last `days` days, today included
+    double countDistinctBuyersRecent(int days) const {
+        int64_t today = dayOf(clock->now());
+        return dailyBuyers.mergedRange(today - days + 1, today).estimate();
+    }
+
+    // Items with the most units sold over the window ending now (up to 24 hours), by
+    // estimated units; see HeavyHitters for the error bounds
+    std::vector<HeavyHitter> getTrendingItems(std::chrono::seconds window, size_t n) const {
+        return trendingItems.top(clock->now(), window, n);
+    }
+
+    double getTrendingErrorBound(std::chrono::seconds window) const {
+        return trendingItems.errorBound(clock->now(), window);
+    }
+
+    // p50/p90/p99 of sale amounts today, over the last 7 days and per seller
+    std::string generateAmountReport() const {
+        std::ostringstream report;
+        int64_t today = dayOf(clock->now());
+        const QuantileSketch* todayAmounts = dailyAmounts.find(today);
+        report << "Sale Amounts:\n";
+        report << "Today: "
+               << (todayAmounts ? todayAmounts->summary() : QuantileSketch().summary()) << "\n";
+        report << "Last 7 Days: " << dailyAmounts.mergedRange(today - 6, today).summary()
+               << "\n";
+        for (const auto& pair : sellerAmounts) {
+            report << "Seller " << pair.first << ": " << pair.second.summary() << "\n";
+        }
+        return report.str();
+    }
+
+    // Live memory of the catalog, transaction log, orders and registered users
+    void addMemoryUsage(MemoryReport& report) const {
+        MemoryUsage itemUsage;
+        itemUsage.objects = items.size();
+        itemUsage.addMap(items);
+        for (const auto& pair : items) pair.second.addHeapUsage(itemUsage);
+
+        MemoryUsage transactionUsage;
+        transactions.addMemoryUsage(transactionUsage);
+        transactionUsage.addHashMap(transactionPositions);
+        transactionUsage.addHashMap(sealedOrderLines);
+        transactionUsage.addHashMap(sealedOpen);
+
+        MemoryUsage orderUsage;
+        orderUsage.objects = orders.size();
+        orderUsage.addVector(orders);
+        orderUsage.addHashMap(orderPositions);
+        for (const auto& order : orders) order.addHeapUsage(orderUsage);
+
+        MemoryUsage buyerUsage;
+        buyerUsage.objects = buyers.size();
+        buyerUsage.addMap(buyers);
+        for (const auto& pair : buyers) pair.second.addMemoryUsage(buyerUsage);
+
+        MemoryUsage sellerUsage;
+        sellerUsage.objects = sellers.size();
+        sellerUsage.addMap(sellers);
+        for (const auto& pair : sellers) pair.second.addMemoryUsage(sellerUsage);
+
+        report.add("store.items", itemUsage);
+        report.add("store.transactions", transactionUsage);
+        report.add("store.orders", orderUsage);
+        report.add("store.buyers", buyerUsage);
+        report.add("store.sellers", sellerUsage);
+
+        MemoryUsage sketchUsage;
+        dailyAmounts.addMemoryUsage(sketchUsage);
+        sellerAmounts.addMemoryUsage(sketchUsage);
+        report.add("store.amount_quantiles", sketchUsage);
+
+        MemoryUsage distinctUsage;
+        sellerBuyers.addMemoryUsage(distinctUsage);
+        itemBuyers.addMemoryUsage(distinctUsage);
+        dailyBuyers.addMemoryUsage(distinctUsage);
+        report.add("store.distinct_buyers", distinctUsage);
+
+        MemoryUsage trendingUsage;
+        trendingItems.addMemoryUsage(trendingUsage);
+        report.add("store.trending_items", trendingUsage);
+    }
+
    private:
-    int countTodayTransactions(int userId, bool isBuyer) const {
-        auto now = std::chrono::system_clock::now();
+    bool isBetterSeller(int a, int b) const {
+        int soldA = items.at(a).getSoldCount();
+        int soldB = items.at(b).getSoldCount();
+        return soldA != soldB ? soldA > soldB : a < b;
+    }
+
+    // The limit best sellers among the ids forEachMatch(visit) passes to visit, kept in a
+    // bounded heap with the worst of them on top. An id visited again is either still in
+    // the heap or worse than everything in it, so repeats are dropped without a seen set.
+    template <typename ForEachMatch>
+    std::vector<const Item*> topSellers(ForEachMatch forEachMatch, size_t limit) const {
+        if (limit == 0) return {};
+        auto better = [this](int a, int b) { return isBetterSeller(a, b); };
+        std::vector<int> heap;
+        heap.reserve(limit);
+        forEachMatch([&heap, &better, limit](int id) {
+            if (heap.size() == limit && !better(id, heap.front())) return true;
+            if (std::find(heap.begin(), heap.end(), id) != heap.end()) return true;
+            if (heap.size() == limit) {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.pop_back();
+            }
+            heap.push_back(id);
+            std::push_heap(heap.begin(), heap.end(), better);
+            return true;
+        });
+        std::sort_heap(heap.begin(), heap.end(), better);
+
+        std::vector<const Item*> result;
+        for (int id : heap) result.push_back(&items.at(id));
+        return result;
+    }
+
+    int countTodayTransactions(int userId, bool isBuyer,
+                               std::chrono::system_clock::time_point now) const {
         return std::count_if(
-            transactions.begin(), transactions.end(), [userId, isBuyer, now](const Transaction& t) {
+            transactions.hotBegin(), transactions.hotEnd(),
+            [userId, isBuyer, now](const Transaction& t) {
                 auto diff =
                     std::chrono::duration_cast<std::chrono::hours>(now - t.getTimestamp()).count();
                 return diff <= 24 &&
@@ -0,0 +1,258 @@
+#ifndef TIERED_LOG_H
+#define TIERED_LOG_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+// Reads and writes one log record with the record's own serialize/deserialize
+template <typename Record>
+struct RecordCodec {
+    static void write(const Record& record, std::ofstream& out) { record.serialize(out); }
+    static void read(Record& record, std::ifstream& in) { record.deserialize(in); }
+};
+
+// Append-only log split into a hot tail kept in memory and cold segments on disk.
+// Records are addressed by their position in the whole log; the hot records are a deque
+// starting at position getHotBase(). sealBefore() moves the oldest hot records into
+// immutable segment files, each listed in a directory with its position and time range,
+// so resident memory follows the hot window rather than the full history. Cold records
+// are only read by forEachColdSince() and forEachSince(), which stream the segments that
+// overlap the requested time range from disk. Records are expected to arrive in roughly
+// time order: sealing stops at the first record that is still inside the window, or that
+// the caller wants kept in memory. updateColdSince() rewrites the segments holding records
+// that changed after sealing. An empty file prefix keeps everything in memory.
+template <typename Record, typename Codec = RecordCodec<Record>>
+class TieredLog {
+   public:
+    using value_type = Record;
+    using codec_type = Codec;
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    struct Segment {
+        std::string fileName;
+        size_t firstPosition;
+        size_t count;
+        TimePoint firstTime;
+        TimePoint lastTime;
+    };
+
+    static constexpr size_t SEGMENT_RECORDS = 65536;
+
+   private:
+    std::string filePrefix;
+    std::deque<Record> hot;
+    size_t hotBase = 0;
+    std::vector<Segment> segments;
+
+    static void writeTime(std::ofstream& out, TimePoint time) {
+        auto ticks = time.time_since_epoch().count();
+        out.write(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
+    }
+
+    static bool readTime(std::ifstream& in, TimePoint& time) {
+        TimePoint::duration::rep ticks;
+        if (!in.read(reinterpret_cast<char*>(&ticks), sizeof(ticks))) return false;
+        time = TimePoint(TimePoint::duration(ticks));
+        return true;
+    }
+
+    bool writeSegment(size_t count) {
+        Segment segment{filePrefix + "_" + std::to_string(hotBase) + ".seg", hotBase, count,
+                        hot.front().getTimestamp(), hot.front().getTimestamp()};
+        std::ofstream file(segment.fileName, std::ios::binary);
+        if (!file.is_open()) return false;
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (size_t i = 0; i < count; i++) {
+            Codec::write(hot[i], file);
+            segment.firstTime = std::min(segment.firstTime, hot[i].getTimestamp());
+            segment.lastTime = std::max(segment.lastTime, hot[i].getTimestamp());
+        }
+        file.close();
+        if (!file) return false;
+        segments.push_back(segment);
+        return true;
+    }
+
+    static std::vector<Record> readSegment(const Segment& segment) {
+        std::vector<Record> records;
+        std::ifstream file(segment.fileName, std::ios::binary);
+        size_t count = 0;
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        Record record;
+        for (size_t i = 0; i < count && file; i++) {
+            Codec::read(record, file);
+            if (file) records.push_back(record);
+        }
+        return records;
+    }
+
+    // Replaces a segment file through a temporary file, so a failed write keeps the old one
+    static bool rewriteSegment(const Segment& segment, const std::vector<Record>& records) {
+        std::string temporary = segment.fileName + ".tmp";
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.is_open()) return false;
+        size_t count = records.size();
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& record : records) Codec::write(record, file);
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return std::rename(temporary.c_str(), segment.fileName.c_str()) == 0;
+    }
+
+   public:
+    explicit TieredLog(std::string filePrefix = "") : filePrefix(std::move(filePrefix)) {}
+
+    void push_back(const Record& record) { hot.push_back(record); }
+
+    // Positions in the whole log; operator[] only reaches hot records
+    size_t size() const { return hotBase + hot.size(); }
+    size_t getHotBase() const { return hotBase; }
+    bool isHot(size_t position) const { return position >= hotBase && position < size(); }
+    Record& operator[](size_t position) { return hot[position - hotBase]; }
+    const Record& operator[](size_t position) const { return hot[position - hotBase]; }
+
+    const std::deque<Record>& getHot() const { return hot; }
+    typename std::deque<Record>::const_iterator hotBegin() const { return hot.begin(); }
+    typename std::deque<Record>::const_iterator hotEnd() const { return hot.end(); }
+
+    // Seals the hot prefix older than cutoff into segments of up to SEGMENT_RECORDS records,
+    // stopping at the first record for which canSeal(record) is false.
+    // onSealed(position, record) runs for each sealed record before it leaves memory.
+    // Returns the number of records sealed.
+    template <typename CanSeal, typename OnSealed>
+    size_t sealBefore(TimePoint cutoff, CanSeal canSeal, OnSealed onSealed) {
+        if (filePrefix.empty()) return 0;
+        size_t sealed = 0;
+        while (!hot.empty()) {
+            size_t count = 0;
+            while (count < hot.size() && count < SEGMENT_RECORDS &&
+                   hot[count].getTimestamp() < cutoff && canSeal(hot[count])) {
+                count++;
+            }
+            if (count == 0 || !writeSegment(count)) break;
+            for (size_t i = 0; i < count; i++) onSealed(hotBase + i, hot[i]);
+            hot.erase(hot.begin(), hot.begin() + count);
+            hotBase += count;
+            sealed += count;
+            if (count < SEGMENT_RECORDS) break;
+        }
+        return sealed;
+    }
+
+    size_t sealBefore(TimePoint cutoff) {
+        return sealBefore(cutoff, [](const Record&) { return true; },
+                          [](size_t, const Record&) {});
+    }
+
+    // Runs update(record) on the cold records of every segment reaching from onwards and
+    // rewrites the segments where it returned true (record changed). Once a segment is
+    // rewritten, onUpdated(before, after) runs for each of its changed records; changes to
+    // a segment that cannot be rewritten are dropped. Returns the number of records updated.
+    template <typename Update, typename OnUpdated>
+    size_t updateColdSince(TimePoint from, Update update, OnUpdated onUpdated) {
+        size_t updated = 0;
+        for (const auto& segment : segments) {
+            if (segment.lastTime < from) continue;
+            std::vector<Record> records = readSegment(segment);
+            std::vector<std::pair<size_t, Record>> changed;  // position, record before
+            for (size_t i = 0; i < records.size(); i++) {
+                Record before = records[i];
+                if (update(records[i])) changed.emplace_back(i, before);
+            }
+            if (changed.empty() || !rewriteSegment(segment, records)) continue;
+            for (const auto& pair : changed) onUpdated(pair.second, records[pair.first]);
+            updated += changed.size();
+        }
+        return updated;
+    }
+
+    // Visits the cold records of every segment reaching from onwards, in log order; the
+    // caller filters records by time
+    template <typename Visit>
+    void forEachColdSince(TimePoint from, Visit visit) const {
+        for (const auto& segment : segments) {
+            if (segment.lastTime < from) continue;
+            std::ifstream file(segment.fileName, std::ios::binary);
+            size_t count = 0;
+            file.read(reinterpret_cast<char*>(&count), sizeof(count));
+            Record record;
+            for (size_t i = 0; i < count && file; i++) {
+                Codec::read(record, file);
+                if (file) visit(record);
+            }
+        }
+    }
+
+    // Same, followed by all hot records
+    template <typename Visit>
+    void forEachSince(TimePoint from, Visit visit) const {
+        forEachColdSince(from, visit);
+        for (const auto& record : hot) visit(record);
+    }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        forEachSince(TimePoint::min(), visit);
+    }
+
+    const std::vector<Segment>& getSegments() const { return segments; }
+
+    // Segment directory: count, then file name, first position, count and time range of each
+    void serializeDirectory(std::ofstream& out) const {
+        size_t segmentCount = segments.size();
+        out.write(reinterpret_cast<const char*>(&segmentCount), sizeof(segmentCount));
+        for (const auto& segment : segments) {
+            int nameLength = static_cast<int>(segment.fileName.size());
+            out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+            out.write(segment.fileName.data(), nameLength);
+            out.write(reinterpret_cast<const char*>(&segment.firstPosition),
+                      sizeof(segment.firstPosition));
+            out.write(reinterpret_cast<const char*>(&segment.count), sizeof(segment.count));
+            writeTime(out, segment.firstTime);
+            writeTime(out, segment.lastTime);
+        }
+    }
+
+    // Replaces the directory; call before adding hot records, as it moves the hot base past
+    // the last segment. Returns false when the stream holds no directory (older files).
+    bool deserializeDirectory(std::ifstream& in) {
+        size_t segmentCount = 0;
+        if (!in.read(reinterpret_cast<char*>(&segmentCount), sizeof(segmentCount))) return false;
+        std::vector<Segment> loaded;
+        for (size_t i = 0; i < segmentCount; i++) {
+            Segment segment;
+            int nameLength = 0;
+            if (!in.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength))) return false;
+            segment.fileName.resize(nameLength > 0 ? nameLength : 0);
+            in.read(&segment.fileName[0], segment.fileName.size());
+            in.read(reinterpret_cast<char*>(&segment.firstPosition), sizeof(segment.firstPosition));
+            in.read(reinterpret_cast<char*>(&segment.count), sizeof(segment.count));
+            if (!readTime(in, segment.firstTime) || !readTime(in, segment.lastTime)) return false;
+            loaded.push_back(segment);
+        }
+        segments = std::move(loaded);
+        hotBase = segments.empty() ? 0 : segments.back().firstPosition + segments.back().count;
+        return true;
+    }
+
+    void addMemoryUsage(MemoryUsage& usage) const {
+        usage.objects += hot.size();
+        usage.addDeque(hot);
+        usage.addVector(segments);
+        for (const auto& segment : segments) usage.addString(segment.fileName);
+    }
+};
+
+#endif
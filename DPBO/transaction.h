@@ -5,9 +5,8 @@
 #include <fstream>
 #include <string>
 
-#include "buyer.h"
 #include "item.h"
-#include "seller.h"
+#include "serialization.h"
 
 enum class TransactionStatus { PENDING, PAID, COMPLETED, CANCELED };
 
@@ -21,6 +20,21 @@ class Transaction {
     TransactionStatus status;
     std::chrono::system_clock::time_point timestamp;
 
+    // Order membership; not part of the transaction record, restored from the order log
+    int orderId;
+    int quantity;
+
+    friend struct SerializationAccess;
+
+    // Record layout; orderId and quantity are restored from the order log instead
+    static constexpr auto serializationFields() {
+        return std::make_tuple(
+            serialization::raw(&Transaction::id), serialization::raw(&Transaction::buyerId),
+            serialization::raw(&Transaction::sellerId), serialization::raw(&Transaction::itemId),
+            serialization::raw(&Transaction::amount), serialization::asInt(&Transaction::status),
+            serialization::time(&Transaction::timestamp));
+    }
+
    public:
     Transaction()
         : id(0),
@@ -28,19 +42,24 @@ class Transaction {
           sellerId(0),
           itemId(0),
           amount(0.0),
-          status(TransactionStatus::PENDING) {
+          status(TransactionStatus::PENDING),
+          orderId(0),
+          quantity(1) {
         timestamp = std::chrono::system_clock::now();
     }
 
-    Transaction(int id, int buyerId, int sellerId, int itemId, double amount)
+    // Pass the store clock's time as timestamp so simulated clocks replay deterministically
+    Transaction(int id, int buyerId, int sellerId, int itemId, double amount,
+                std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now())
         : id(id),
           buyerId(buyerId),
           sellerId(sellerId),
           itemId(itemId),
           amount(amount),
-          status(TransactionStatus::PENDING) {
-        timestamp = std::chrono::system_clock::now();
-    }
+          status(TransactionStatus::PENDING),
+          timestamp(timestamp),
+          orderId(0),
+          quantity(1) {}
 
     // Getters
     int getId() const { return id; }
@@ -50,43 +69,52 @@ class Transaction {
     double getAmount() const { return amount; }
     TransactionStatus getStatus() const { return status; }
     std::chrono::system_clock::time_point getTimestamp() const { return timestamp; }
+    int getOrderId() const { return orderId; }
+    int getQuantity() const { return quantity; }
+    bool isOrderLine() const { return orderId != 0; }
 
     // Setters
     void setStatus(TransactionStatus status) { this->status = status; }
+    void setTimestamp(std::chrono::system_clock::time_point timestamp) {
+        this->timestamp = timestamp;
+    }
+    void setOrder(int orderId, int quantity) {
+        this->orderId = orderId;
+        this->quantity = quantity;
+    }
+    // Units bought by a single transaction (one unless set), e.g. a multi-unit checkout
+    void setQuantity(int quantity) { this->quantity = quantity; }
 
     // Serialization
-    void serialize(std::ofstream& out) const {
-        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
-        out.write(reinterpret_cast<const char*>(&buyerId), sizeof(buyerId));
-        out.write(reinterpret_cast<const char*>(&sellerId), sizeof(sellerId));
-        out.write(reinterpret_cast<const char*>(&itemId), sizeof(itemId));
-        out.write(reinterpret_cast<const char*>(&amount), sizeof(amount));
-        auto status_val = static_cast<int>(status);
-        out.write(reinterpret_cast<const char*>(&status_val), sizeof(status_val));
-        auto time = timestamp.time_since_epoch().count();
-        out.write(reinterpret_cast<const char*>(&time), sizeof(time));
-    }
+    void serialize(std::ofstream& out) const { serialization::write(*this, out); }
+    void deserialize(std::ifstream& in) { serialization::read(*this, in); }
 
-    void deserialize(std::ifstream& in) {
-        in.read(reinterpret_cast<char*>(&id), sizeof(id));
-        in.read(reinterpret_cast<char*>(&buyerId), sizeof(buyerId));
-        in.read(reinterpret_cast<char*>(&sellerId), sizeof(sellerId));
-        in.read(reinterpret_cast<char*>(&itemId), sizeof(itemId));
-        in.read(reinterpret_cast<char*>(&amount), sizeof(amount));
-        int status_val;
-        in.read(reinterpret_cast<char*>(&status_val), sizeof(status_val));
-        status = static_cast<TransactionStatus>(status_val);
-        typename std::chrono::system_clock::duration::rep time;
-        in.read(reinterpret_cast<char*>(&time), sizeof(time));
-        timestamp =
-            std::chrono::system_clock::time_point(std::chrono::system_clock::duration(time));
+    bool isWithinDays(int days) const {
+        return isWithinDays(days, std::chrono::system_clock::now());
     }
 
-    bool isWithinDays(int days) const {
-        auto now = std::chrono::system_clock::now();
+    // Same check against a "now" captured once by the caller
+    bool isWithinDays(int days, std::chrono::system_clock::time_point now) const {
         auto diff = std::chrono::duration_cast<std::chrono::hours>(now - timestamp).count();
         return diff <= (days * 24);
     }
 };
 
+// Record of a Transaction in sealed store log segments: the transaction record, then its
+// order id and quantity, which the store data file otherwise restores from the order log
+struct SealedTransactionCodec {
+    static void write(const Transaction& transaction, std::ofstream& out) {
+        transaction.serialize(out);
+        int order[2] = {transaction.getOrderId(), transaction.getQuantity()};
+        out.write(reinterpret_cast<const char*>(order), sizeof(order));
+    }
+
+    static void read(Transaction& transaction, std::ifstream& in) {
+        transaction.deserialize(in);
+        int order[2] = {0, 1};
+        in.read(reinterpret_cast<char*>(order), sizeof(order));
+        transaction.setOrder(order[0], order[1]);
+    }
+};
+
 #endif
\ No newline at end of file
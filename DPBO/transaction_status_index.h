@@ -0,0 +1,150 @@
+#ifndef TRANSACTION_STATUS_INDEX_H
+#define TRANSACTION_STATUS_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "transaction.h"
+
+// Partitions the positions of a transaction vector by TransactionStatus.
+// Each status keeps an intrusive doubly-linked list threaded through one slot per
+// position, so a status change is an O(1) unlink/append and listing a status only
+// touches the transactions that currently have it, oldest first. Slots live in a deque
+// starting at a base position, so the oldest positions can be dropped when the indexed
+// log moves them out of memory.
+class TransactionStatusIndex {
+   private:
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+    static constexpr size_t STATUS_COUNT = 4;
+
+    struct Slot {
+        TransactionStatus status;
+        size_t prev;
+        size_t next;
+    };
+
+    std::deque<Slot> slots;
+    size_t base;  // position of slots.front()
+    std::array<size_t, STATUS_COUNT> heads;
+    std::array<size_t, STATUS_COUNT> tails;
+    std::array<size_t, STATUS_COUNT> counts;
+
+    static size_t bucket(TransactionStatus status) { return static_cast<size_t>(status); }
+
+    Slot& slot(size_t position) { return slots[position - base]; }
+    const Slot& slot(size_t position) const { return slots[position - base]; }
+
+    void link(size_t position, TransactionStatus status) {
+        size_t b = bucket(status);
+        slot(position) = {status, tails[b], NONE};
+        if (tails[b] != NONE) {
+            slot(tails[b]).next = position;
+        } else {
+            heads[b] = position;
+        }
+        tails[b] = position;
+        counts[b]++;
+    }
+
+    void unlink(size_t position) {
+        Slot& unlinked = slot(position);
+        size_t b = bucket(unlinked.status);
+        if (unlinked.prev != NONE) {
+            slot(unlinked.prev).next = unlinked.next;
+        } else {
+            heads[b] = unlinked.next;
+        }
+        if (unlinked.next != NONE) {
+            slot(unlinked.next).prev = unlinked.prev;
+        } else {
+            tails[b] = unlinked.prev;
+        }
+        counts[b]--;
+    }
+
+   public:
+    // Forward iterator over the positions queued under one status, oldest first
+    class PositionIterator {
+       private:
+        const TransactionStatusIndex* index;
+        size_t position;
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t*;
+        using reference = const size_t&;
+
+        PositionIterator(const TransactionStatusIndex* index, size_t position)
+            : index(index), position(position) {}
+
+        reference operator*() const { return position; }
+
+        PositionIterator& operator++() {
+            position = index->slot(position).next;
+            return *this;
+        }
+
+        bool operator==(const PositionIterator& other) const { return position == other.position; }
+        bool operator!=(const PositionIterator& other) const { return position != other.position; }
+    };
+
+    TransactionStatusIndex() { clear(); }
+
+    // Registers the transaction stored at the next position of the indexed log
+    void add(TransactionStatus status) {
+        slots.push_back({status, NONE, NONE});
+        link(base + slots.size() - 1, status);
+    }
+
+    // Moves an indexed transaction to another status queue
+    void setStatus(size_t position, TransactionStatus status) {
+        if (position < base || position - base >= slots.size()) return;
+        if (slot(position).status == status) return;
+        unlink(position);
+        link(position, status);
+    }
+
+    // Forgets the oldest count positions; they are no longer counted or listed
+    void dropFront(size_t count) {
+        for (size_t i = 0; i < count && !slots.empty(); i++) {
+            unlink(base);
+            slots.pop_front();
+            base++;
+        }
+    }
+
+    // Positions of all transactions with the given status, oldest first
+    std::vector<size_t> positions(TransactionStatus status) const {
+        std::vector<size_t> result;
+        result.reserve(counts[bucket(status)]);
+        for (size_t p = heads[bucket(status)]; p != NONE; p = slot(p).next) {
+            result.push_back(p);
+        }
+        return result;
+    }
+
+    PositionIterator begin(TransactionStatus status) const {
+        return PositionIterator(this, heads[bucket(status)]);
+    }
+
+    PositionIterator end() const { return PositionIterator(this, NONE); }
+
+    size_t count(TransactionStatus status) const { return counts[bucket(status)]; }
+
+    // Empties the index; the next transaction added gets position base
+    void clear(size_t base = 0) {
+        slots.clear();
+        this->base = base;
+        heads.fill(NONE);
+        tails.fill(NONE);
+        counts.fill(0);
+    }
+};
+
+#endif
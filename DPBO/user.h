@@ -4,6 +4,8 @@
 #include <chrono>
 #include <string>
 
+#include "memory_usage.h"
+
 class User {
    protected:
     int id;
@@ -35,6 +37,9 @@ class User {
 
     virtual void logout() { loginState = false; }
 
+    // Heap memory of the user's own strings
+    void addHeapUsage(MemoryUsage& usage) const { usage.addString(name); }
+
     // Virtual method for getting user info
     virtual std::string getInfo() const { return "ID: " + std::to_string(id) + ", Name: " + name; }
 
@@ -0,0 +1,210 @@
+#ifndef VELOCITY_LIMITER_H
+#define VELOCITY_LIMITER_H
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+// Outgoing transfer limits over a rolling 24 hours
+struct VelocityLimits {
+    int maxTransfers = std::numeric_limits<int>::max();
+    double maxAmount = std::numeric_limits<double>::infinity();
+};
+
+// Per-account rolling-window transfer limits, checked on every transfer.
+// Accounts are keyed by their index in the bank's customer table, so the state is a dense
+// array with no keys or hashing. Each account has 24 hourly buckets plus running totals;
+// amounts are kept in whole cents. A check first retires the buckets that fell out of the
+// window and then compares the totals, so its cost does not depend on the ledger size.
+// The window moves forward one hour at a time. A bucket holds at most 65535 transfers and
+// about 42.9 million in amount; a transfer that would overflow its hour is rejected.
+// Limits are configured per tier; accounts are in tier 0 until assigned, and tiers without
+// limits are unlimited. Only the configuration (tier limits and account tiers) is saved;
+// the windows are rebuilt from the ledger.
+class VelocityLimiter {
+   private:
+    static constexpr int WINDOW_HOURS = 24;
+
+    struct Window {
+        int32_t headHour = 0;  // hour of the newest bucket
+        uint32_t totalCount = 0;
+        uint64_t totalCents = 0;
+        uint16_t counts[WINDOW_HOURS] = {};
+        uint32_t cents[WINDOW_HOURS] = {};
+
+        // Retires the buckets older than the 24 hours ending at hour
+        void advance(int32_t hour) {
+            if (hour <= headHour) return;
+            if (hour - headHour >= WINDOW_HOURS) {
+                *this = Window();
+            } else {
+                for (int32_t h = headHour + 1; h <= hour; h++) {
+                    int slot = h % WINDOW_HOURS;
+                    totalCount -= counts[slot];
+                    totalCents -= cents[slot];
+                    counts[slot] = 0;
+                    cents[slot] = 0;
+                }
+            }
+            headHour = hour;
+        }
+
+        // Whether one more transfer of amountCents fits in the bucket for hour
+        bool fits(int32_t hour, uint64_t amountCents) const {
+            int slot = hour % WINDOW_HOURS;
+            return counts[slot] < std::numeric_limits<uint16_t>::max() &&
+                   amountCents <= std::numeric_limits<uint32_t>::max() - cents[slot];
+        }
+
+        void add(int32_t hour, uint64_t amountCents) {
+            int slot = hour % WINDOW_HOURS;
+            counts[slot]++;
+            cents[slot] += static_cast<uint32_t>(amountCents);
+            totalCount++;
+            totalCents += amountCents;
+        }
+    };
+
+    struct Slot {
+        int tier = 0;
+        Window window;
+    };
+
+    std::vector<Slot> slots;  // indexed by account
+    std::vector<VelocityLimits> tiers;
+    size_t rejected = 0;
+
+    static int32_t hourOf(std::chrono::system_clock::time_point time) {
+        return static_cast<int32_t>(
+            std::chrono::duration_cast<std::chrono::hours>(time.time_since_epoch()).count());
+    }
+
+    static uint64_t centsOf(double amount) {
+        return static_cast<uint64_t>(std::llround(amount * 100));
+    }
+
+    Slot& slotOf(uint32_t account) {
+        if (account >= slots.size()) slots.resize(account + 1);
+        return slots[account];
+    }
+
+    const VelocityLimits& limitsOf(int tier) const {
+        static const VelocityLimits unlimited;
+        return tier >= 0 && tier < static_cast<int>(tiers.size()) ? tiers[tier] : unlimited;
+    }
+
+   public:
+    void setTierLimits(int tier, const VelocityLimits& limits) {
+        if (tier < 0) return;
+        if (tier >= static_cast<int>(tiers.size())) tiers.resize(tier + 1);
+        tiers[tier] = limits;
+    }
+
+    void setAccountTier(uint32_t account, int tier) { slotOf(account).tier = tier; }
+
+    int getAccountTier(uint32_t account) const {
+        return account < slots.size() ? slots[account].tier : 0;
+    }
+
+    // Checks a transfer against the account's limits and counts it when it fits.
+    // Only positive amounts are transfers; anything else is refused without counting.
+    bool tryConsume(uint32_t account, double amount, std::chrono::system_clock::time_point now) {
+        if (!(amount > 0.0)) return false;
+        Slot& slot = slotOf(account);
+        int32_t hour = hourOf(now);
+        slot.window.advance(hour);
+
+        const VelocityLimits& limits = limitsOf(slot.tier);
+        uint64_t cents = centsOf(amount);
+        if (static_cast<int64_t>(slot.window.totalCount) + 1 > limits.maxTransfers ||
+            (slot.window.totalCents + cents) / 100.0 > limits.maxAmount ||
+            !slot.window.fits(hour, cents)) {
+            rejected++;
+            return false;
+        }
+        slot.window.add(hour, cents);
+        return true;
+    }
+
+    // Counts a past transfer without checking it, e.g. when replaying the ledger on load
+    void record(uint32_t account, double amount, std::chrono::system_clock::time_point time,
+                std::chrono::system_clock::time_point now) {
+        int32_t hour = hourOf(time);
+        int32_t currentHour = hourOf(now);
+        if (!(amount > 0.0) || hour > currentHour || currentHour - hour >= WINDOW_HOURS) return;
+        Slot& slot = slotOf(account);
+        slot.window.advance(currentHour);
+        uint64_t cents = centsOf(amount);
+        if (slot.window.fits(hour, cents)) slot.window.add(hour, cents);
+    }
+
+    // Transfers and amount counted in the account's current window
+    std::pair<int, double> usage(uint32_t account, std::chrono::system_clock::time_point now) {
+        if (account >= slots.size()) return {0, 0.0};
+        Window& window = slots[account].window;
+        window.advance(hourOf(now));
+        return {static_cast<int>(window.totalCount), window.totalCents / 100.0};
+    }
+
+    // Tier limits, then the accounts outside tier 0 as (account, tier)
+    void serialize(std::ofstream& out) const {
+        size_t tierCount = tiers.size();
+        out.write(reinterpret_cast<const char*>(&tierCount), sizeof(tierCount));
+        for (const auto& limits : tiers) {
+            out.write(reinterpret_cast<const char*>(&limits.maxTransfers),
+                      sizeof(limits.maxTransfers));
+            out.write(reinterpret_cast<const char*>(&limits.maxAmount), sizeof(limits.maxAmount));
+        }
+        std::vector<std::pair<uint32_t, int32_t>> assigned;
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].tier != 0) assigned.emplace_back(static_cast<uint32_t>(i), slots[i].tier);
+        }
+        size_t assignedCount = assigned.size();
+        out.write(reinterpret_cast<const char*>(&assignedCount), sizeof(assignedCount));
+        for (const auto& pair : assigned) {
+            out.write(reinterpret_cast<const char*>(&pair.first), sizeof(pair.first));
+            out.write(reinterpret_cast<const char*>(&pair.second), sizeof(pair.second));
+        }
+    }
+
+    // Replaces the configuration; false (and unchanged) when the block is missing or cut short
+    bool deserialize(std::ifstream& in) {
+        size_t tierCount = 0;
+        if (!in.read(reinterpret_cast<char*>(&tierCount), sizeof(tierCount))) return false;
+        std::vector<VelocityLimits> loadedTiers(tierCount);
+        for (auto& limits : loadedTiers) {
+            in.read(reinterpret_cast<char*>(&limits.maxTransfers), sizeof(limits.maxTransfers));
+            in.read(reinterpret_cast<char*>(&limits.maxAmount), sizeof(limits.maxAmount));
+        }
+        size_t assignedCount = 0;
+        in.read(reinterpret_cast<char*>(&assignedCount), sizeof(assignedCount));
+        std::vector<std::pair<uint32_t, int32_t>> assigned(in ? assignedCount : 0);
+        for (auto& pair : assigned) {
+            in.read(reinterpret_cast<char*>(&pair.first), sizeof(pair.first));
+            in.read(reinterpret_cast<char*>(&pair.second), sizeof(pair.second));
+        }
+        if (!in) return false;
+        tiers = std::move(loadedTiers);
+        for (auto& slot : slots) slot.tier = 0;
+        for (const auto& pair : assigned) setAccountTier(pair.first, pair.second);
+        return true;
+    }
+
+    size_t getRejectedCount() const { return rejected; }
+    size_t size() const { return slots.size(); }
+
+    void addMemoryUsage(MemoryUsage& usage) const {
+        usage.objects += slots.size();
+        usage.addVector(slots);
+        usage.addVector(tiers);
+    }
+};
+
+#endif